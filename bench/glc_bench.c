@@ -0,0 +1,337 @@
+/*	---------------------------------------------------------------------
+ *	glc_bench.c - microbenchmarks for glc.h
+ *	Times shader program builds and uniform uploads in a headless EGL
+ *	context and prints one JSON object per result line, for regression
+ *	tracking.
+ *
+ *	Build (Linux, Mesa or any EGL driver with surfaceless contexts):
+ *		cc -O2 -o glc_bench bench/glc_bench.c -lEGL -lGL
+ *	Run:
+ *		./glc_bench [--quick] [--filter substring] > results.jsonl
+ *
+ *	Each line holds the benchmark name, the iterations per batch and the
+ *	minimum and median nanoseconds per operation over the batches. The
+ *	shader builds are measured cold (fresh source every build, no binary
+ *	cache) and warm (same source with the program binary cache enabled).
+ *
+ *	Copyright 2017 Patrick Cland
+ *	www.setsunasoft.com
+ *
+ *	Same license as glc.h.
+ *	----------------------------------------------------------------------------- */
+
+#define _POSIX_C_SOURCE 200809L
+#define GL_GLEXT_PROTOTYPES
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <time.h>
+#include <dirent.h>
+#include "../glc.h"
+
+#define BENCH_BATCHES 5
+#define BENCH_MAX_BATCHES 16
+
+typedef struct benchShader
+{
+	const char* name;
+	int functions;		/* generated helper functions, sets the source size */
+	int builds;			/* builds per batch */
+} benchShader;
+
+static const benchShader benchShaders[] =
+{
+	{ "small", 1, 16 },
+	{ "medium", 32, 8 },
+	{ "huge", 256, 2 }
+};
+
+static const char* benchFilter = NULL;
+static int benchQuick = 0;
+static char benchDirectory[256];
+
+static double benchSeconds(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+static int benchSelected(const char* name)
+{
+	return !benchFilter || strstr(name, benchFilter);
+}
+
+static int benchCompare(const void* a, const void* b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static void benchReport(const char* name, int iterations, double* batches, int count)
+{
+	qsort(batches, count, sizeof(double), benchCompare);
+	printf("{\"name\":\"%s\",\"iterations\":%d,\"batches\":%d,\"min_ns\":%.1f,\"median_ns\":%.1f}\n",
+		name, iterations, count, batches[0] * 1e9 / iterations, batches[count / 2] * 1e9 / iterations);
+	fflush(stdout);
+}
+
+static EGLContext benchContext(void)
+{
+	EGLint major, minor;
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLContext context;
+	EGLint attributes[] =
+	{
+		EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE
+	};
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+	if(getPlatformDisplay)
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+#endif
+	if(display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+		return EGL_NO_CONTEXT;
+	context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+	if(context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+		return EGL_NO_CONTEXT;
+	return context;
+}
+
+static int benchWrite(const char* path, const char* text)
+{
+	FILE* file = fopen(path, "wb");
+	if(!file)
+		return -1;
+	fputs(text, file);
+	fclose(file);
+	return 1;
+}
+
+/* Writes a fragment shader calling a chain of generated functions. The
+   salt goes into a comment so every cold build sees a new source string. */
+static int benchWriteShader(const char* path, int functions, int salt)
+{
+	int i, result;
+	size_t length = 0;
+	char* text = (char*)malloc(256 + (size_t)functions * 160);
+
+	if(!text)
+		return -1;
+	length += sprintf(text + length, "#version 330 core\n// %d\nuniform vec4 tint;\nout vec4 color;\n", salt);
+	length += sprintf(text + length, "vec4 f0(vec4 v) { return sin(v * 1.5) * 0.5; }\n");
+	for(i = 1; i < functions; i++)
+		length += sprintf(text + length, "vec4 f%d(vec4 v) { return f%d(v * %d.5 + sin(v.yzwx)) * 0.5; }\n", i, i - 1, i + 1);
+	sprintf(text + length, "void main() { color = f%d(tint); }\n", functions - 1);
+	result = benchWrite(path, text);
+	free(text);
+	return result;
+}
+
+static void benchBuilds(void)
+{
+	int i, b, s, builds;
+	double batches[BENCH_MAX_BATCHES], start;
+	char vertexPath[300], fragmentPath[300], cachePath[300], name[64];
+	GLuint program;
+
+	sprintf(vertexPath, "%s/bench.vert", benchDirectory);
+	sprintf(fragmentPath, "%s/bench.frag", benchDirectory);
+	sprintf(cachePath, "%s/cache", benchDirectory);
+	if(benchWrite(vertexPath, "#version 330 core\nlayout(location = 0) in vec4 position;\n"
+		"void main() { gl_Position = position; }\n") == -1)
+		return;
+	for(s = 0; s < (int)(sizeof(benchShaders) / sizeof(benchShaders[0])); s++)
+	{
+		builds = benchQuick ? 1 : benchShaders[s].builds;
+		/* cold: a new source per build, so neither glc nor the driver can reuse anything */
+		sprintf(name, "build_cold_%s", benchShaders[s].name);
+		if(benchSelected(name))
+		{
+			glcSetProgramBinaryCache(NULL);
+			for(b = 0; b < BENCH_BATCHES; b++)
+			{
+				batches[b] = 0.0;
+				for(i = 0; i < builds; i++)
+				{
+					benchWriteShader(fragmentPath, benchShaders[s].functions, rand());
+					start = benchSeconds();
+					if(glcMakeShaderProgram(&program, vertexPath, fragmentPath) == -1)
+						return;
+					batches[b] += benchSeconds() - start;
+					glcDeleteShaderProgram(program);
+				}
+			}
+			benchReport(name, builds, batches, BENCH_BATCHES);
+		}
+		/* warm: the same source again, served by the program binary cache */
+		sprintf(name, "build_warm_%s", benchShaders[s].name);
+		if(benchSelected(name))
+		{
+			mkdir(cachePath, 0755);
+			glcSetProgramBinaryCache(cachePath);
+			benchWriteShader(fragmentPath, benchShaders[s].functions, 0);
+			if(glcMakeShaderProgram(&program, vertexPath, fragmentPath) == -1)
+				return;
+			glcDeleteShaderProgram(program);
+			for(b = 0; b < BENCH_BATCHES; b++)
+			{
+				start = benchSeconds();
+				for(i = 0; i < builds; i++)
+				{
+					if(glcMakeShaderProgram(&program, vertexPath, fragmentPath) == -1)
+						return;
+					glcDeleteShaderProgram(program);
+				}
+				batches[b] = benchSeconds() - start;
+			}
+			benchReport(name, builds, batches, BENCH_BATCHES);
+			glcSetProgramBinaryCache(NULL);
+		}
+	}
+}
+
+static const char* benchUniformVertex =
+	"#version 330 core\n"
+	"layout(location = 0) in vec4 position;\n"
+	"uniform mat4 transform;\n"
+	"uniform vec4 offsets[16];\n"
+	"void main() { gl_Position = transform * position + offsets[gl_VertexID & 15]; }\n";
+
+static const char* benchUniformFragment =
+	"#version 330 core\n"
+	"uniform vec4 tint;\n"
+	"uniform int mode;\n"
+	"out vec4 color;\n"
+	"void main() { color = tint * float(mode); }\n";
+
+/* One batch of iterations uniform uploads, finished with glFinish so
+   deferred driver work is counted too. */
+#define BENCH_UNIFORM(label, setup, call) \
+	if(benchSelected(label)) \
+	{ \
+		setup; \
+		for(b = 0; b < BENCH_BATCHES; b++) \
+		{ \
+			start = benchSeconds(); \
+			for(i = 0; i < iterations; i++) \
+			{ \
+				value = (GLfloat)i; \
+				call; \
+			} \
+			glFinish(); \
+			batches[b] = benchSeconds() - start; \
+		} \
+		benchReport(label, iterations, batches, BENCH_BATCHES); \
+	}
+
+static void benchUniforms(void)
+{
+	int i, b, iterations = benchQuick ? 20000 : 500000;
+	double batches[BENCH_MAX_BATCHES], start;
+	GLfloat value, offsets[64], transform[16];
+	GLint tint, mode, offsetsLocation, transformLocation;
+	GLuint program;
+	glcUniformHandle tintHandle;
+
+	if(glcMakeShaderProgramSource(&program, benchUniformVertex, -1, benchUniformFragment, -1) == -1)
+		return;
+	tint = glGetUniformLocation(program, "tint");
+	mode = glGetUniformLocation(program, "mode");
+	offsetsLocation = glGetUniformLocation(program, "offsets");
+	transformLocation = glGetUniformLocation(program, "transform");
+	tintHandle = glcGetUniformHandle(program, "tint");
+	for(i = 0; i < 64; i++)
+		offsets[i] = (GLfloat)i;
+	for(i = 0; i < 16; i++)
+		transform[i] = (GLfloat)(i % 5 == 0);
+
+	/* scalar vectors */
+	BENCH_UNIFORM("uniform4f_raw", (glUseProgram(program), glcInvalidateState()),
+		glUniform4f(tint, value, 1.0f, 2.0f, 3.0f))
+	BENCH_UNIFORM("uniform4f_handle", (void)0,
+		glcUniform4f(tintHandle, value, 1.0f, 2.0f, 3.0f))
+	BENCH_UNIFORM("uniform4f_setuniformx", (void)0,
+		glcSetUniformx(program, "tint", GL_FLOAT, 4, (double)value, 1.0, 2.0, 3.0))
+	BENCH_UNIFORM("uniform1i_raw", (glUseProgram(program), glcInvalidateState()),
+		glUniform1i(mode, i))
+	BENCH_UNIFORM("uniform1i_setuniformx", (void)0,
+		glcSetUniformx(program, "mode", GL_INT, 1, i))
+
+	/* arrays */
+	BENCH_UNIFORM("uniform4fv16_raw", (glUseProgram(program), glcInvalidateState()),
+		(offsets[0] = value, glUniform4fv(offsetsLocation, 16, offsets)))
+	BENCH_UNIFORM("uniform4fv16_setuniformxv", (void)0,
+		(offsets[0] = value, glcSetUniformxv(program, "offsets", GL_FLOAT, 4, 16, offsets)))
+
+	/* matrices */
+	BENCH_UNIFORM("uniformmatrix4fv_raw", (glUseProgram(program), glcInvalidateState()),
+		(transform[12] = value, glUniformMatrix4fv(transformLocation, 1, GL_FALSE, transform)))
+	BENCH_UNIFORM("uniformmatrix4fv_setuniformmatx", (void)0,
+		(transform[12] = value, glcSetUniformMatx(program, "transform", 4, 1, GL_FALSE, transform)))
+
+	glcDeleteShaderProgram(program);
+}
+
+/* Empties and removes a directory one level deep. */
+static void benchRemove(const char* path)
+{
+	char entryPath[600];
+	struct dirent* entry;
+	DIR* directory = opendir(path);
+
+	if(!directory)
+		return;
+	while((entry = readdir(directory)))
+	{
+		if(!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+			continue;
+		sprintf(entryPath, "%.299s/%.299s", path, entry->d_name);
+		if(remove(entryPath))
+			benchRemove(entryPath);
+	}
+	closedir(directory);
+	remove(path);
+}
+
+int main(int argc, char** argv)
+{
+	int i;
+	const char* temp = getenv("TMPDIR");
+
+	for(i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], "--quick"))
+			benchQuick = 1;
+		else if(!strcmp(argv[i], "--filter") && i + 1 < argc)
+			benchFilter = argv[++i];
+		else
+		{
+			fprintf(stderr, "usage: %s [--quick] [--filter substring]\n", argv[0]);
+			return 1;
+		}
+	}
+	if(benchContext() == EGL_NO_CONTEXT)
+	{
+		fprintf(stderr, "Error creating a headless OpenGL 3.3 core context.\n");
+		return 1;
+	}
+	sprintf(benchDirectory, "%.200s/glc_bench_XXXXXX", temp ? temp : "/tmp");
+	if(!mkdtemp(benchDirectory))
+	{
+		fprintf(stderr, "Error creating a scratch directory.\n");
+		return 1;
+	}
+	fprintf(stderr, "%s | %s\n", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+	srand((unsigned int)time(NULL));
+	benchBuilds();
+	benchUniforms();
+	benchRemove(benchDirectory);
+	return 0;
+}
@@ -1,296 +1,6518 @@
-/*	---------------------------------------------------------------------
- *	glc.h - OpenGL Common function library
- *	Performs frequently used common tasks in OpenGL
- *	
- *
- *	Copyright 2017 Patrick Cland
- *	www.setsunasoft.com
- *
- *	Permission is hereby granted, free of charge, to any person obtaining 
- *	a copy of this software and associated documentation files (the "Software"),
- *	to deal in the Software without restriction, including without limitation
- *	the rights to use, copy, modify, merge, publish, distribute, sublicense, 
- *	and/or sell copies of the Software, and to permit persons to whom the 
- *	Software is furnished to do so, subject to the following conditions:
- *
- *	The above copyright notice and this permission notice shall be included
- *	in all copies or substantial portions of the Software.
-
- *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
- *	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
- *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
- *	THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
- *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
- *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
- *	SOFTWARE.
- *	----------------------------------------------------------------------------- */
-
-#ifndef GLC_H
-#define GLC_H
-
-#ifdef _MSC_VER
-#define _CRT_SECURE_NO_WARNINGS
-#endif
-
-#include <stdio.h>
-#include <malloc.h>
-#include <stdarg.h>
-
-#ifndef GL_VERSION
-#error OpenGL not defined. Make sure to include the OpenGL library before including glc.h
-#endif
-
-/* Defines */
-
-
-/*	glcMakeShaderProgram()
-	Returns: 1 (success) or -1 (failure)
-	program - pointer to a to be shader program handle
-	vertexShaderPath - path to vertex shader source code file
-	fragmentShaderPath - path to fragment shader source code file */
-int glcMakeShaderProgram(GLuint* program, const char* vertexShaderPath, const char* fragmentShaderPath)
-{
-	int length = 0;
-	int success;
-	char* source = NULL;
-	char infoLog[512];
-	FILE* vertexFile, *fragmentFile;
-	GLuint vertexShader, fragmentShader;
-
-	if(!(vertexFile = fopen(vertexShaderPath, "rb")))
-	{
-		fprintf(stderr, "Error opening vertex shader: %s\n", vertexShaderPath);
-		return -1;
-	}
-	if(!(fragmentFile = fopen(fragmentShaderPath, "rb")))
-	{
-		fprintf(stderr, "Error opening fragment shader: %s\n", fragmentShaderPath);
-		fclose(vertexFile);
-		return -1;
-	}
-	/* Compile Vertex Shader */
-	do { length++; } while(fgetc(vertexFile) != EOF);
-	fseek(vertexFile, 0, SEEK_SET);
-	source = calloc(length + 1, sizeof(char));
-	fread(source, sizeof(char), length, vertexFile);
-	vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	if(!vertexShader)
-	{
-		fprintf(stderr, "Error creating vertex shader object.\n");
-		fclose(vertexFile); fclose(fragmentFile);
-		free(source);
-		return -1;
-	}
-	glShaderSource(vertexShader, 1, &source, NULL);
-	glCompileShader(vertexShader);
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-	if(!success)
-	{
-		glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-		fprintf(stderr, "Vertex shader compilation error!\n%s\n", infoLog);
-		fclose(vertexFile); fclose(fragmentFile);
-		free(source);
-		return -1;
-	}
-	free(source);
-	/* Compile Fragment Shader */
-	length = 0;
-	do{ length++; } while(fgetc(fragmentFile) != EOF);
-	fseek(fragmentFile, 0, SEEK_SET);
-	source = calloc(length + 1, sizeof(char));
-	fread(source, sizeof(char), length, fragmentFile);
-	fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	if(!fragmentShader)
-	{
-		fprintf(stderr, "Error creating fragment shader object.\n");
-		fclose(vertexFile); fclose(fragmentFile);
-		free(source);
-		return -1;
-	}
-	glShaderSource(fragmentShader, 1, &source, NULL);
-	glCompileShader(fragmentShader);
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-	if(!success)
-	{
-		glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-		fprintf(stderr, "Fragment shader compilation error!\n%s\n", infoLog);
-		fclose(vertexFile); fclose(fragmentFile);
-		free(source);
-		return -1;
-	}
-	fclose(vertexFile); fclose(fragmentFile);
-	free(source);
-	/* Create Shader Program */
-	*program = glCreateProgram();
-	if(!(*program))
-	{
-		fprintf(stderr, "Error creating shader program object.\n");
-		return -1;
-	}
-	glAttachShader(*program, vertexShader);
-	glAttachShader(*program, fragmentShader);
-	glLinkProgram(*program);
-	glGetProgramiv(*program, GL_LINK_STATUS, &success);
-	if(!success)
-	{
-		glGetProgramInfoLog(*program, 512, NULL, infoLog);
-		fprintf(stderr, "Shader program linking error!\n%s\n", infoLog);
-		return -1;
-	}
-
-	/* cleanup */
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-	return 1;
-}
-
-/*	glcSetUniformx()
-	Returns: 1 (success) or -1 (failure)
-	program - shader program handle
-	name - name of uniform
-	type - data type to be sent to shader
-		Accepted values are: GL_FLOAT, GL_INT, GL_UNSIGNED_INT
-		Anything else is treated as GL_UNSIGNED_INT
-	dimension - value of 1-4 to show size of uniform 
-	... - 1 to 4 values for uniform */
-int glcSetUniformx(GLuint program, const char* name, int type, int dimension, ...)
-{
-	int i;
-	void* data;
-	GLint location;
-	va_list vl;
-
-	if(dimension < 1 || dimension > 4)
-	{
-		fprintf(stderr, "Dimension invalid. Must be 1-4. Got %d.\n", dimension);
-		return -1;
-	}
-	location = glGetUniformLocation(program, name);
-	if(location == -1)
-	{
-		fprintf(stderr, "Uniform name invalid: %s\n", name);
-		return -1;
-	}
-	glUseProgram(program);
-
-	va_start(vl, dimension);
-	data = malloc(	(type == GL_FLOAT) ? sizeof(GLfloat) * dimension :
-					(type == GL_INT) ? sizeof(GLint) * dimension :
-					sizeof(GLuint) * dimension);
-	if(!data)
-	{
-		fprintf(stderr, "Error allocating memory when setting uniform.\n");
-		va_end(vl);
-		return -1;
-	}
-	for(i = 0; i < dimension; i++)
-	{
-		if(type == GL_FLOAT)
-			((GLfloat*)data)[i] = (GLfloat)va_arg(vl, double);
-		else if(type == GL_INT)
-			((GLint*)data)[i] = (GLint)va_arg(vl, int);
-		else
-			((GLuint*)data)[i] = (GLuint)va_arg(vl, unsigned int);
-	}
-	va_end(vl);
-
-	if(dimension == 1)
-		(type == GL_FLOAT)	? glUniform1fv(location, 1, (GLfloat*)data) :
-		(type == GL_INT)	? glUniform1iv(location, 1, (GLint*)data) :
-		glUniform1uiv(location, 1, (GLuint*)data);
-	else if(dimension == 2)
-		(type == GL_FLOAT)	? glUniform2fv(location, 1, (GLfloat*)data) :
-		(type == GL_INT)	? glUniform2iv(location, 1, (GLint*)data) :
-		glUniform2uiv(location, 1, (GLuint*)data);
-	else if(dimension == 3)
-		(type == GL_FLOAT)	? glUniform3fv(location, 1, (GLfloat*)data) :
-		(type == GL_INT)	? glUniform3iv(location, 1, (GLint*)data) :
-		glUniform3uiv(location, 1, (GLuint*)data);
-	else
-		(type == GL_FLOAT)	? glUniform4fv(location, 1, (GLfloat*)data) :
-		(type == GL_INT)	? glUniform4iv(location, 1, (GLint*)data) :
-		glUniform4uiv(location, 1, (GLuint*)data);
-
-	free(data);
-	return 1;
-}
-
-/*	glcSetUniformxv()
-	Returns: 1 (success) or -1 (failure)
-	program - shader program handle
-	name - name of uniform
-	type - data type to be sent to shader
-		Accepted values are: GL_FLOAT, GL_INT, GL_UNSIGNED_INT
-		Anything else is treated as GL_UNSIGNED_INT
-	dimension - value of 1-4 to show size of uniform array element
-	amount - amount of elements in uniform array to set
-	uniform - pointer to contiguous uniform values*/
-int glcSetUniformxv(GLuint program, const char* name, int type, int dimension, int amount, const void* uniform)
-{
-	GLint location;
-
-	if(dimension < 1 || dimension > 4)
-	{
-		fprintf(stderr, "Dimension invalid. Must be 1-4. Got %d.\n", dimension);
-		return -1;
-	}
-	if(amount <= 0)
-	{
-		fprintf(stderr, "Amount invalid. Must be larger than 0. Got %d\n", amount);
-		return -1;
-	}
-	location = glGetUniformLocation(program, name);
-	if(location == -1)
-	{
-		fprintf(stderr, "Uniform name invalid: %s\n", name);
-		return -1;
-	}
-	glUseProgram(program);
-
-	if(dimension == 1)
-		(type == GL_FLOAT)	? glUniform1fv(location, amount, (GLfloat*)uniform) :
-		(type == GL_INT)	? glUniform1iv(location, amount, (GLint*)uniform) :
-		glUniform1uiv(location, amount, (GLuint*)uniform);
-	else if(dimension == 2)
-		(type == GL_FLOAT)	? glUniform2fv(location, amount, (GLfloat*)uniform) :
-		(type == GL_INT)	? glUniform2iv(location, amount, (GLint*)uniform) :
-		glUniform2uiv(location, amount, (GLuint*)uniform);
-	else if(dimension == 3)
-		(type == GL_FLOAT)	? glUniform3fv(location, amount, (GLfloat*)uniform) :
-		(type == GL_INT)	? glUniform3iv(location, amount, (GLint*)uniform) :
-		glUniform3uiv(location, amount, (GLuint*)uniform);
-	else
-		(type == GL_FLOAT)	? glUniform4fv(location, amount, (GLfloat*)uniform) :
-		(type == GL_INT)	? glUniform4iv(location, amount, (GLint*)uniform) :
-		glUniform4uiv(location, amount, (GLuint*)uniform);
-
-	return 1;
-}
-
-int glcSetUniformMatx(GLuint program, const char* name, int dimension, int amount, GLboolean transpose, const void* uniform)
-{
-	GLint location;
-	if(dimension < 2 || dimension > 4)
-	{
-		fprintf(stderr, "Dimension invalid. Must be 2-4. Got %d.\n", dimension);
-		return -1;
-	}
-	location = glGetUniformLocation(program, name);
-	if(location == -1)
-	{
-		fprintf(stderr, "Uniform name invalid: %s\n", name);
-		return -1;
-	}
-	glUseProgram(program);
-
-	if(dimension == 2)
-		glUniformMatrix2fv(location, amount, transpose, (GLfloat*)uniform);
-	else if(dimension == 3)
-		glUniformMatrix3fv(location, amount, transpose, (GLfloat*)uniform);
-	else
-		glUniformMatrix4fv(location, amount, transpose, (GLfloat*)uniform);
-
-	return 1;
-}
-
-#endif
+/*	---------------------------------------------------------------------
+ *	glc.h - OpenGL Common function library
+ *	Performs frequently used common tasks in OpenGL
+ *	
+ *
+ *	Copyright 2017 Patrick Cland
+ *	www.setsunasoft.com
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining 
+ *	a copy of this software and associated documentation files (the "Software"),
+ *	to deal in the Software without restriction, including without limitation
+ *	the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *	and/or sell copies of the Software, and to permit persons to whom the 
+ *	Software is furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included
+ *	in all copies or substantial portions of the Software.
+
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *	OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+ *	THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+ *	SOFTWARE.
+ *	----------------------------------------------------------------------------- */
+
+#ifndef GLC_H
+#define GLC_H
+
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <stdarg.h>
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define GLC_HAS_MMAP
+#endif
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+#ifdef GLC_STATS
+#include <time.h>
+#endif
+#ifndef GLC_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GLC_SSE
+#if defined(__F16C__)
+#include <immintrin.h>
+#define GLC_F16C
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define GLC_NEON
+#if defined(__aarch64__) || (defined(__ARM_FP) && (__ARM_FP & 2))
+#define GLC_NEON_FP16
+#endif
+#endif
+#endif
+
+#ifndef GL_VERSION
+#error OpenGL not defined. Make sure to include the OpenGL library before including glc.h
+#endif
+
+/*	Memory
+	Only setup functions allocate: the glcMake* and glcGet*Block functions,
+	glcCacheUniformLocations, glcSetUniformMode and the first uniform lookup on
+	a program linked outside of glc. Everything meant to run per frame
+	(glcUseProgram, the uniform lookups, every glcSetUniform* and glcUniform*
+	setter, glcFlushUniforms and the ring functions) never touches the heap.
+	Command buffers and glcSubmitCommandBuffers grow their storage up to the
+	largest frame seen and allocate no more after that. */
+
+/* Defines */
+
+/*	GLC_DIRECT_STATE_ACCESS
+	Define before including glc.h to have the uniform setters write through
+	glProgramUniform* (GL 4.1 / ARB_separate_shader_objects) so no program
+	ever needs binding to set its uniforms. */
+#if defined(GLC_DIRECT_STATE_ACCESS) && !defined(GL_VERSION_4_1) && !defined(GL_ARB_separate_shader_objects)
+#error GLC_DIRECT_STATE_ACCESS requires OpenGL 4.1 or ARB_separate_shader_objects
+#endif
+
+#define GLC_UNKNOWN_PROGRAM ((GLuint)~0u)
+#define GLC_MAX_SHADER_STAGES 6
+
+/*	Threads
+	Thread local storage and the few atomic operations behind the context
+	model, see Contexts. Compilers with neither get a single threaded build. */
+#if defined(__GNUC__) || defined(__clang__)
+#define GLC_THREAD_LOCAL __thread
+#define GLC_LOAD_POINTER(pointer) __atomic_load_n(pointer, __ATOMIC_ACQUIRE)
+#define GLC_STORE_POINTER(pointer, value) __atomic_store_n(pointer, value, __ATOMIC_RELEASE)
+#define GLC_LOAD_INT(pointer) __atomic_load_n(pointer, __ATOMIC_ACQUIRE)
+#define GLC_STORE_INT(pointer, value) __atomic_store_n(pointer, value, __ATOMIC_RELEASE)
+#define GLC_ADD_INT(pointer, value) ((void)__atomic_add_fetch(pointer, value, __ATOMIC_ACQ_REL))
+#define GLC_LOCK(lock) while(__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE))
+#define GLC_UNLOCK(lock) __atomic_store_n(lock, 0, __ATOMIC_RELEASE)
+#elif defined(_MSC_VER)
+#define GLC_THREAD_LOCAL __declspec(thread)
+#define GLC_LOAD_POINTER(pointer) InterlockedCompareExchangePointer((PVOID volatile*)(pointer), NULL, NULL)
+#define GLC_STORE_POINTER(pointer, value) ((void)InterlockedExchangePointer((PVOID volatile*)(pointer), (PVOID)(value)))
+#define GLC_LOAD_INT(pointer) InterlockedCompareExchange((volatile LONG*)(pointer), 0, 0)
+#define GLC_STORE_INT(pointer, value) ((void)InterlockedExchange((volatile LONG*)(pointer), (LONG)(value)))
+#define GLC_ADD_INT(pointer, value) ((void)InterlockedExchangeAdd((volatile LONG*)(pointer), value))
+#define GLC_LOCK(lock) while(InterlockedExchange((volatile LONG*)(lock), 1))
+#define GLC_UNLOCK(lock) ((void)InterlockedExchange((volatile LONG*)(lock), 0))
+#else
+#define GLC_THREAD_LOCAL
+#define GLC_LOAD_POINTER(pointer) (*(pointer))
+#define GLC_STORE_POINTER(pointer, value) ((void)(*(pointer) = (value)))
+#define GLC_LOAD_INT(pointer) (*(pointer))
+#define GLC_STORE_INT(pointer, value) ((void)(*(pointer) = (value)))
+#define GLC_ADD_INT(pointer, value) ((void)(*(pointer) += (value)))
+#define GLC_LOCK(lock) ((void)(lock))
+#define GLC_UNLOCK(lock) ((void)(lock))
+#endif
+
+/*	Diagnostics
+	Every failure records a glcError, read and cleared by glcGetError(), and
+	passes a message to the log callback, which prints to stderr unless
+	replaced through glcSetLogCallback(). A NULL callback silences glc, and
+	messages are then not even formatted.
+	Define GLC_NO_DIAGNOSTICS before including glc.h to compile every message
+	out; only the error codes remain. */
+typedef enum glcError
+{
+	GLC_ERROR_NONE = 0,
+	GLC_ERROR_INVALID_VALUE,		/* an argument is out of range */
+	GLC_ERROR_INVALID_OPERATION,	/* the call does not fit the object or the current state */
+	GLC_ERROR_NOT_FOUND,			/* no uniform, block or pack entry by that name */
+	GLC_ERROR_FILE,					/* a file could not be opened, read or written */
+	GLC_ERROR_OUT_OF_MEMORY,
+	GLC_ERROR_GL_OBJECT,			/* the driver did not create an object */
+	GLC_ERROR_COMPILE,				/* preprocessing or compiling a shader failed */
+	GLC_ERROR_LINK
+} glcError;
+
+typedef void (*glcLogCallback)(glcError error, const char* message, void* user);
+
+static GLC_THREAD_LOCAL glcError glc_lastError = GLC_ERROR_NONE;	/* per thread, like errno */
+
+#ifndef GLC_NO_DIAGNOSTICS
+
+static void glc_stderrLog(glcError error, const char* message, void* user)
+{
+	(void)error;
+	(void)user;
+	fprintf(stderr, "%s\n", message);
+}
+
+static glcLogCallback glc_logCallback = glc_stderrLog;
+static void* glc_logUser = NULL;
+
+static void glc_log(glcError error, const char* format, ...)
+{
+	int length;
+	char buffer[1024], *message = buffer;
+	va_list vl;
+
+	glc_lastError = error;
+	if(!glc_logCallback)
+		return;
+	va_start(vl, format);
+	length = vsnprintf(buffer, sizeof(buffer), format, vl);
+	va_end(vl);
+	/* long info logs get a buffer of their own */
+	if(length >= (int)sizeof(buffer) && (message = (char*)malloc(length + 1)))
+	{
+		va_start(vl, format);
+		vsnprintf(message, length + 1, format, vl);
+		va_end(vl);
+	}
+	glc_logCallback(error, message ? message : buffer, glc_logUser);
+	if(message != buffer)
+		free(message);
+}
+
+#define GLC_LOG(error, ...) glc_log(error, __VA_ARGS__)
+
+/* Returns the whole info log of a shader or program, however long, to be
+   released with free(), or NULL if there is none or nobody listens. */
+static char* glc_getInfoLog(GLuint object, GLboolean program)
+{
+	GLint length = 0;
+	char* log;
+
+	if(!glc_logCallback)
+		return NULL;
+	if(program)
+		glGetProgramiv(object, GL_INFO_LOG_LENGTH, &length);
+	else
+		glGetShaderiv(object, GL_INFO_LOG_LENGTH, &length);
+	if(length < 1 || !(log = (char*)malloc(length)))
+		return NULL;
+	log[0] = '\0';
+	if(program)
+		glGetProgramInfoLog(object, length, NULL, log);
+	else
+		glGetShaderInfoLog(object, length, NULL, log);
+	return log;
+}
+
+#else
+#define GLC_LOG(error, ...) ((void)(glc_lastError = (error)))
+#define glc_getInfoLog(object, program) ((char*)NULL)
+#endif
+
+/*	glcSetLogCallback()
+	callback - receives every diagnostic message, or NULL for silence
+	user - passed to the callback untouched
+	Has no effect with GLC_NO_DIAGNOSTICS. */
+void glcSetLogCallback(glcLogCallback callback, void* user)
+{
+#ifndef GLC_NO_DIAGNOSTICS
+	glc_logCallback = callback;
+	glc_logUser = user;
+#else
+	(void)callback;
+	(void)user;
+#endif
+}
+
+/*	glcGetError()
+	Returns: the error of the latest failed glc call since the last
+	glcGetError, then resets it to GLC_ERROR_NONE */
+glcError glcGetError(void)
+{
+	glcError error = glc_lastError;
+	glc_lastError = GLC_ERROR_NONE;
+	return error;
+}
+
+/*	glcErrorString()
+	Returns: the name of an error code */
+const char* glcErrorString(glcError error)
+{
+	switch(error)
+	{
+	case GLC_ERROR_NONE:				return "GLC_ERROR_NONE";
+	case GLC_ERROR_INVALID_VALUE:		return "GLC_ERROR_INVALID_VALUE";
+	case GLC_ERROR_INVALID_OPERATION:	return "GLC_ERROR_INVALID_OPERATION";
+	case GLC_ERROR_NOT_FOUND:			return "GLC_ERROR_NOT_FOUND";
+	case GLC_ERROR_FILE:				return "GLC_ERROR_FILE";
+	case GLC_ERROR_OUT_OF_MEMORY:		return "GLC_ERROR_OUT_OF_MEMORY";
+	case GLC_ERROR_GL_OBJECT:			return "GLC_ERROR_GL_OBJECT";
+	case GLC_ERROR_COMPILE:				return "GLC_ERROR_COMPILE";
+	case GLC_ERROR_LINK:				return "GLC_ERROR_LINK";
+	default:							return "unknown glc error";
+	}
+}
+
+/*	GLC_STATS
+	Define before including glc.h to turn on instrumentation, read through
+	glcGetStats(). Without it every counter compiles away. CPU times are wall
+	clock seconds spent inside glc; with parallel shader compile most of the
+	compile and link work happens on driver threads and only the waits are
+	counted. On POSIX systems define _POSIX_C_SOURCE (199309L or later)
+	before including anything in strict ISO C modes, or clock() is used. */
+#ifdef GLC_STATS
+
+#define GLC_MAX_GPU_TIMERS 16
+#define GLC_GPU_TIMER_LATENCY 4	/* frames a GPU timer result may lag behind */
+
+typedef struct glcFrameStats
+{
+	unsigned int uniformCalls;		/* glUniform* / glProgramUniform* calls made */
+	unsigned int binds;				/* glUseProgram calls made */
+	unsigned int redundantBinds;	/* glcUseProgram calls skipped by the tracker */
+	unsigned int locationLookups;	/* glcGetUniformLocation calls */
+	unsigned int driverLookups;		/* of those, passed on to glGetUniformLocation */
+	unsigned int bufferWaits;		/* stream buffer allocations that waited on the GPU */
+	unsigned int redundantUniforms;	/* sets dropped by the uniform shadow, value unchanged */
+	unsigned int materialSkips;		/* glcApplyMaterial calls skipped, material current */
+} glcFrameStats;
+
+typedef struct glcStats
+{
+	/* totals since startup or glcResetStats */
+	double fileTime;			/* reading shader sources */
+	double compileTime;			/* submitting and waiting on shader compiles */
+	double linkTime;			/* submitting and waiting on program links */
+	unsigned int programsBuilt;
+	unsigned int binaryCacheHits;
+	/* per frame */
+	glcFrameStats frame;		/* counting, since the last glcEndStatsFrame */
+	glcFrameStats lastFrame;	/* complete counts of the previous frame */
+	/* GPU timers, see glcBeginGpuTimer */
+	const char* timerNames[GLC_MAX_GPU_TIMERS];
+	double gpuTime[GLC_MAX_GPU_TIMERS];	/* latest result in milliseconds */
+	unsigned int timerDrops;	/* scopes skipped because their ring was full */
+} glcStats;
+
+typedef struct glcGpuTimer
+{
+	GLuint queries[GLC_GPU_TIMER_LATENCY];
+	int head;		/* next query to issue */
+	int pending;	/* issued and not read, the oldest is pending slots behind head */
+} glcGpuTimer;
+
+#define GLC_STAT(expression) ((void)(glc_getContext()->stats.expression))
+#else
+#define GLC_STAT(expression) ((void)0)
+#endif
+
+/*	Contexts
+	A glcContext holds what glc tracks per GL context: the bound program,
+	pipeline and vertex array, the program pipelines and vertex arrays glc
+	created, resident texture handles, GPU timers, statistics and what the
+	driver supports. Give every GL
+	context that uses glc a glcContext of its own and pass it to
+	glcMakeCurrent() whenever that GL context is made current on a thread.
+	Threads that never do share a default context, so single threaded
+	programs need none of this.
+	Program information, the uniform caches and shader variants belong to the
+	share group and are shared by all contexts, which are expected to share
+	objects with each other. Programs can be built on a worker context while
+	another thread renders: lookups never lock, and registering or dropping a
+	program takes a short spin lock. Finish a program on the thread that
+	began it before handing it over, and delete it only once no other thread
+	uses it. Once any thread has made a context of its own current, what glc
+	kept for a deleted program stays allocated for lookups that may still be
+	reading it, until glcFreeRetiredPrograms() is called at a point where no
+	other thread is inside glc. The binary cache directory, the log callback and hot reload are
+	meant to be set up and driven from a single thread. */
+struct glcPipeline;
+struct glcResidentHandle;
+struct glcVertexArray;
+struct glcCommandPacket;
+
+typedef struct glcContext
+{
+	GLuint currentProgram;
+	GLuint currentPipeline;
+	GLuint currentVertexArray;
+	int parallelCompile;	/* -1 until checked */
+	int programInterface;	/* -1 until checked, 2 on GL 4.3, 1 through the extension */
+	int bindless;			/* -1 until checked */
+	int spirv;				/* -1 until checked */
+	int indirectCount;		/* -1 until checked */
+	GLint storageAlignment;	/* 0 until queried */
+	struct glcPipeline* pipelines;
+	int pipelineCount;
+	int pipelineCapacity;	/* power of two */
+	struct glcResidentHandle* residentHandles;
+	int residentCount;
+	int residentCapacity;	/* power of two */
+	struct glcVertexArray* vertexArrays;
+	int vertexArrayCount;
+	int vertexArrayCapacity;	/* power of two */
+	struct glcCommandPacket* packets;	/* scratch of glcSubmitCommandBuffers */
+	int packetCapacity;
+#ifdef GLC_STATS
+	glcStats stats;
+	glcGpuTimer gpuTimers[GLC_MAX_GPU_TIMERS];
+	int runningTimer;
+#endif
+} glcContext;
+
+static GLC_THREAD_LOCAL glcContext* glc_context = NULL;
+static glcContext glc_defaultContext;
+static int glc_defaultReady = 0;
+static int glc_shareLock = 0;	/* writers of the program and variant tables, default context setup */
+static int glc_threadContexts = 0;	/* set once a thread makes a context of its own current */
+
+/*	glcMakeContext()
+	context - pointer to a to be glc context */
+void glcMakeContext(glcContext* context)
+{
+	memset(context, 0, sizeof(glcContext));
+	context->currentProgram = GLC_UNKNOWN_PROGRAM;
+	context->currentPipeline = GLC_UNKNOWN_PROGRAM;
+	context->currentVertexArray = GLC_UNKNOWN_PROGRAM;
+	context->parallelCompile = context->programInterface = context->bindless = context->spirv = context->indirectCount = -1;
+#ifdef GLC_STATS
+	context->runningTimer = -1;
+#endif
+}
+
+static glcContext* glc_getContext(void)
+{
+	if(glc_context)
+		return glc_context;
+	/* threads without a context of their own may race to set it up */
+	if(!GLC_LOAD_INT(&glc_defaultReady))
+	{
+		GLC_LOCK(&glc_shareLock);
+		if(!glc_defaultReady)
+		{
+			glcMakeContext(&glc_defaultContext);
+			GLC_STORE_INT(&glc_defaultReady, 1);
+		}
+		GLC_UNLOCK(&glc_shareLock);
+	}
+	return &glc_defaultContext;
+}
+
+/*	glcMakeCurrent()
+	context - glc context of the GL context now current on this thread, or
+		NULL to go back to the default context */
+void glcMakeCurrent(glcContext* context)
+{
+	if(context && !GLC_LOAD_INT(&glc_threadContexts))
+		GLC_STORE_INT(&glc_threadContexts, 1);
+	glc_context = context;
+}
+
+/*	glcGetCurrentContext()
+	Returns: the glc context of this thread, the default one if none was
+	made current */
+glcContext* glcGetCurrentContext(void)
+{
+	return glc_getContext();
+}
+
+#ifdef GLC_STATS
+
+#if defined(_WIN32)
+static double glc_seconds(void)
+{
+	LARGE_INTEGER count, frequency;
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&frequency);
+	return (double)count.QuadPart / (double)frequency.QuadPart;
+}
+#elif defined(CLOCK_MONOTONIC)
+static double glc_seconds(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+#else
+static double glc_seconds(void)
+{
+	return (double)clock() / CLOCKS_PER_SEC;
+}
+#endif
+
+/*	glcGetStats()
+	Returns: the live statistics of the current context, valid for the
+	lifetime of that context */
+const glcStats* glcGetStats(void)
+{
+	return &glc_getContext()->stats;
+}
+
+/*	glcResetStats()
+	Zeroes every counter and time of the current context. GPU timer names
+	are kept. */
+void glcResetStats(void)
+{
+	int i;
+	glcContext* context = glc_getContext();
+
+	for(i = 0; i < GLC_MAX_GPU_TIMERS; i++)
+		context->stats.gpuTime[i] = 0.0;
+	context->stats.fileTime = context->stats.compileTime = context->stats.linkTime = 0.0;
+	context->stats.programsBuilt = context->stats.binaryCacheHits = context->stats.timerDrops = 0;
+	memset(&context->stats.frame, 0, sizeof(glcFrameStats));
+	memset(&context->stats.lastFrame, 0, sizeof(glcFrameStats));
+}
+
+#if defined(GL_VERSION_3_3) || defined(GL_ARB_timer_query)
+
+/* Reads every finished result of a timer without waiting. */
+static void glc_collectGpuTimer(int timer)
+{
+	GLint available;
+	GLuint64 elapsed;
+	glcContext* context = glc_getContext();
+	glcGpuTimer* ring = &context->gpuTimers[timer];
+
+	while(ring->pending)
+	{
+		GLuint query = ring->queries[(ring->head - ring->pending + GLC_GPU_TIMER_LATENCY) % GLC_GPU_TIMER_LATENCY];
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if(!available)
+			return;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+		context->stats.gpuTime[timer] = (double)elapsed * 1e-6;
+		ring->pending--;
+	}
+}
+
+/*	glcBeginGpuTimer()
+	Returns: 1 (timing), 0 (skipped this time) or -1 (failure)
+	timer - index of the timer, 0 to GLC_MAX_GPU_TIMERS - 1
+	name - label stored in the stats for telemetry, not copied
+	Starts a GL_TIME_ELAPSED scope, ended by glcEndGpuTimer. Scopes do not
+	nest. A result shows up in glcStats.gpuTime a few frames later; when the
+	GPU lags so far that every query of the timer is still in flight the
+	scope is skipped instead of waiting. */
+int glcBeginGpuTimer(int timer, const char* name)
+{
+	glcGpuTimer* ring;
+	glcContext* context = glc_getContext();
+
+	if(timer < 0 || timer >= GLC_MAX_GPU_TIMERS)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "GPU timer invalid. Must be 0-%d. Got %d.", GLC_MAX_GPU_TIMERS - 1, timer);
+		return -1;
+	}
+	if(context->runningTimer != -1)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "GPU timer %d started while timer %d is running.", timer, context->runningTimer);
+		return -1;
+	}
+	ring = &context->gpuTimers[timer];
+	if(!ring->queries[0])
+		glGenQueries(GLC_GPU_TIMER_LATENCY, ring->queries);
+	context->stats.timerNames[timer] = name;
+	glc_collectGpuTimer(timer);
+	if(ring->pending == GLC_GPU_TIMER_LATENCY)
+	{
+		context->stats.timerDrops++;
+		return 0;
+	}
+	glBeginQuery(GL_TIME_ELAPSED, ring->queries[ring->head]);
+	context->runningTimer = timer;
+	return 1;
+}
+
+/*	glcEndGpuTimer()
+	Ends the running GPU timer scope, if any. */
+void glcEndGpuTimer(void)
+{
+	glcGpuTimer* ring;
+	glcContext* context = glc_getContext();
+
+	if(context->runningTimer == -1)
+		return;
+	ring = &context->gpuTimers[context->runningTimer];
+	glEndQuery(GL_TIME_ELAPSED);
+	ring->head = (ring->head + 1) % GLC_GPU_TIMER_LATENCY;
+	ring->pending++;
+	context->runningTimer = -1;
+}
+
+#endif
+
+/*	glcEndStatsFrame()
+	Call once per frame: moves the per frame counts to lastFrame and picks
+	up finished GPU timer results. */
+void glcEndStatsFrame(void)
+{
+	glcContext* context = glc_getContext();
+#if defined(GL_VERSION_3_3) || defined(GL_ARB_timer_query)
+	int i;
+
+	for(i = 0; i < GLC_MAX_GPU_TIMERS; i++)
+		glc_collectGpuTimer(i);
+#endif
+	context->stats.lastFrame = context->stats.frame;
+	memset(&context->stats.frame, 0, sizeof(glcFrameStats));
+}
+
+#endif
+
+/*	Bound state tracking
+	glc remembers which program and vertex array it last bound so redundant
+	glUseProgram and glBindVertexArray calls are skipped. If the application
+	binds either directly, it must call glcInvalidateState() afterwards. */
+/* number of programs submitted with glcBeginShaderProgram but not finished */
+static int glc_pendingPrograms = 0;
+
+int glcFinishShaderProgram(GLuint program);
+
+/*	glcUseProgram()
+	program - shader program handle, or 0 to unbind
+	Binds the program unless it is already current. A program still being
+	built by glcBeginShaderProgram is finished first. */
+void glcUseProgram(GLuint program)
+{
+	glcContext* context = glc_getContext();
+
+	if(program == context->currentProgram)
+	{
+		GLC_STAT(frame.redundantBinds++);
+		return;
+	}
+	if(GLC_LOAD_INT(&glc_pendingPrograms) && program)
+		glcFinishShaderProgram(program);
+	GLC_STAT(frame.binds++);
+	glUseProgram(program);
+	context->currentProgram = program;
+}
+
+#if defined(GL_VERSION_3_0) || defined(GL_ARB_vertex_array_object)
+
+/*	glcBindVertexArray()
+	vertexArray - vertex array object handle, or 0 to unbind
+	Binds the vertex array unless it is already current. */
+void glcBindVertexArray(GLuint vertexArray)
+{
+	glcContext* context = glc_getContext();
+
+	if(vertexArray == context->currentVertexArray)
+		return;
+	glBindVertexArray(vertexArray);
+	context->currentVertexArray = vertexArray;
+}
+
+#endif
+
+/*	glcInvalidateState()
+	Forgets the tracked bind state of the current context, so the next
+	glcUseProgram, glcBindProgramPipeline or glcBindVertexArray always binds. */
+void glcInvalidateState(void)
+{
+	glcContext* context = glc_getContext();
+
+	context->currentProgram = GLC_UNKNOWN_PROGRAM;
+	context->currentPipeline = GLC_UNKNOWN_PROGRAM;
+	context->currentVertexArray = GLC_UNKNOWN_PROGRAM;
+}
+
+/*	Uniform location cache and program reflection
+	Every program known to glc gets a glcProgramInfo holding its reflection:
+	a flat array of every active uniform, uniform block, storage block, input
+	and output with its type, array size, location or binding, plus a hashed
+	table of uniform names and their locations. Both are filled in one go
+	after the program links, through the program interface queries on GL 4.3
+	or from glGetActiveUniform and glGetActiveAttrib before that (uniforms and
+	attributes only), so a lookup that misses is authoritative and the driver
+	is never asked again. Programs linked outside of glc are filled the first
+	time a uniform is looked up on them. */
+enum
+{
+	GLC_RESOURCE_UNIFORM_BLOCK, GLC_RESOURCE_STORAGE_BLOCK, GLC_RESOURCE_UNIFORM,
+	GLC_RESOURCE_INPUT, GLC_RESOURCE_OUTPUT,
+	GLC_RESOURCE_INTERFACES
+};
+
+typedef struct glcProgramResource
+{
+	const char* name;	/* as reported by GL, "name[0]" for arrays of basic types */
+	int interface;		/* GLC_RESOURCE_* */
+	GLenum type;		/* 0 for blocks */
+	GLint size;			/* array size, 1 for non arrays, 0 for unsized arrays */
+	GLint location;		/* uniforms outside of blocks, inputs and outputs, else -1 */
+	GLint block;		/* uniforms in a block: index of the block in the resources, else -1 */
+	GLint binding;		/* blocks: buffer binding point */
+	GLint dataSize;		/* blocks: minimum buffer size */
+} glcProgramResource;
+
+typedef struct glcUniformEntry
+{
+	unsigned int hash;
+	int name;			/* offset into glcProgramInfo::names, -1 if slot empty */
+	GLint location;
+} glcUniformEntry;
+
+typedef struct glcProgramInfo
+{
+	GLuint program;
+	struct glcProgramInfo* retired;	/* next deleted program awaiting glcFreeRetiredPrograms */
+	int uniformCount;
+	int uniformCapacity;	/* power of two */
+	glcUniformEntry* uniforms;
+	int namesLength;
+	int namesCapacity;
+	char* names;
+	/* reflection, see glcGetProgramResources */
+	int resourceCount;
+	glcProgramResource* resources;
+	char* resourceNames;
+	GLint locationCount;	/* highest uniform location + 1 */
+	int* locationResources;	/* resource of each uniform location, -1 if none */
+	int* locationNext;		/* location of the next element of the same array, -1 if none; shares locationResources' allocation */
+	/* uniform shadow, see glcSetUniformMode */
+	int uniformMode;		/* GLC_UNIFORMS_* */
+	int dirtyCount;
+	GLint slotCount;		/* highest location + 1 */
+	int* slotOffsets;		/* into shadow, -1 if no uniform there */
+	int* slotRemaining;		/* array elements from the location to the end of its array */
+	unsigned char* slotSizes;	/* bytes of one element of the declared type */
+	unsigned char* slotKinds;	/* kind of the value last stored */
+	unsigned char* slotFlags;	/* GLC_SLOT_* */
+	unsigned char* shadow;
+	unsigned long long materialHash;	/* material known to be current, 0 if none */
+	/* asynchronous build, see glcBeginShaderProgram */
+	GLboolean pending;
+	int pendingCount;
+	GLuint pendingShaders[GLC_MAX_SHADER_STAGES];
+	unsigned long long binaryKey;
+	unsigned long long variantKey;	/* permutation key when built by glcMakeProgramVariant */
+	GLbitfield separableStages;	/* stage bits of a separable program, else 0 */
+	GLint workGroupSize[3];	/* compute programs, queried on first dispatch */
+} glcProgramInfo;
+
+/* The program table is shared by every context and read without locking.
+   Writers serialise on glc_shareLock and publish a slot's info before its
+   key. A removed program leaves a tombstone key that later inserts reuse,
+   so probe runs never move under a reader, and a table replaced by a
+   larger one stays allocated for readers that may still be probing it. */
+typedef struct glcProgramTable
+{
+	unsigned int mask;		/* capacity - 1, capacity is a power of two */
+	struct glcProgramTable* retired;	/* the table this one replaced */
+	glcProgramInfo** infos;
+	GLuint* keys;			/* 0 if empty, GLC_UNKNOWN_PROGRAM if removed */
+} glcProgramTable;
+
+static glcProgramTable* glc_programs = NULL;
+static int glc_programCount = 0;
+static unsigned int glc_programSlots = 0;	/* keys in use, tombstones included */
+static int glc_programGeneration = 0;		/* bumped by every removal */
+static glcProgramInfo* glc_retiredPrograms = NULL;	/* removed, awaiting glcFreeRetiredPrograms */
+/* lookup cache of this thread, valid while no program was removed since */
+static GLC_THREAD_LOCAL GLuint glc_lastKey = 0;
+static GLC_THREAD_LOCAL glcProgramInfo* glc_lastProgram = NULL;
+static GLC_THREAD_LOCAL int glc_lastGeneration = 0;
+/* number of programs in filtered or deferred uniform mode, tested by every setter */
+static int glc_uniformHooks = 0;
+
+/* FNV-1a */
+static unsigned int glc_hashString(const char* s)
+{
+	unsigned int hash = 2166136261u;
+	while(*s)
+	{
+		hash ^= (unsigned char)*s++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static unsigned int glc_hashProgram(GLuint program)
+{
+	unsigned int hash = (unsigned int)program;
+	hash ^= hash >> 16;
+	hash *= 0x45d9f3bu;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+/* Returns the size in bytes of one component of a uniform type and its
+   column and row counts, or 0 for types that have no value layout. */
+static int glc_typeShape(GLenum type, int* columns, int* rows)
+{
+	*columns = 1;
+	switch(type)
+	{
+	case GL_FLOAT: case GL_INT: case GL_UNSIGNED_INT: case GL_BOOL:
+		*rows = 1; return 4;
+	case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_BOOL_VEC2:
+		*rows = 2; return 4;
+	case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_BOOL_VEC3:
+		*rows = 3; return 4;
+	case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_BOOL_VEC4:
+		*rows = 4; return 4;
+	case GL_FLOAT_MAT2:		*columns = 2; *rows = 2; return 4;
+	case GL_FLOAT_MAT3:		*columns = 3; *rows = 3; return 4;
+	case GL_FLOAT_MAT4:		*columns = 4; *rows = 4; return 4;
+	case GL_FLOAT_MAT2x3:	*columns = 2; *rows = 3; return 4;
+	case GL_FLOAT_MAT2x4:	*columns = 2; *rows = 4; return 4;
+	case GL_FLOAT_MAT3x2:	*columns = 3; *rows = 2; return 4;
+	case GL_FLOAT_MAT3x4:	*columns = 3; *rows = 4; return 4;
+	case GL_FLOAT_MAT4x2:	*columns = 4; *rows = 2; return 4;
+	case GL_FLOAT_MAT4x3:	*columns = 4; *rows = 3; return 4;
+#if defined(GL_VERSION_4_0) || defined(GL_ARB_gpu_shader_fp64)
+	case GL_DOUBLE:			*rows = 1; return 8;
+	case GL_DOUBLE_VEC2:	*rows = 2; return 8;
+	case GL_DOUBLE_VEC3:	*rows = 3; return 8;
+	case GL_DOUBLE_VEC4:	*rows = 4; return 8;
+	case GL_DOUBLE_MAT2:	*columns = 2; *rows = 2; return 8;
+	case GL_DOUBLE_MAT3:	*columns = 3; *rows = 3; return 8;
+	case GL_DOUBLE_MAT4:	*columns = 4; *rows = 4; return 8;
+	case GL_DOUBLE_MAT2x3:	*columns = 2; *rows = 3; return 8;
+	case GL_DOUBLE_MAT2x4:	*columns = 2; *rows = 4; return 8;
+	case GL_DOUBLE_MAT3x2:	*columns = 3; *rows = 2; return 8;
+	case GL_DOUBLE_MAT3x4:	*columns = 3; *rows = 4; return 8;
+	case GL_DOUBLE_MAT4x2:	*columns = 4; *rows = 2; return 8;
+	case GL_DOUBLE_MAT4x3:	*columns = 4; *rows = 3; return 8;
+#endif
+	default:
+		*rows = 0; return 0;
+	}
+}
+
+static glcProgramInfo* glc_findProgram(GLuint program)
+{
+	unsigned int i;
+	GLuint key;
+	int generation = GLC_LOAD_INT(&glc_programGeneration);
+	glcProgramTable* table;
+	glcProgramInfo* info;
+
+	/* compared by name, the cached info may be freed by now */
+	if(glc_lastKey == program && glc_lastGeneration == generation && glc_lastProgram)
+		return glc_lastProgram;
+	table = (glcProgramTable*)GLC_LOAD_POINTER(&glc_programs);
+	if(!table || program == GLC_UNKNOWN_PROGRAM)
+		return NULL;
+	for(i = glc_hashProgram(program) & table->mask; (key = (GLuint)GLC_LOAD_INT(&table->keys[i])); i = (i + 1) & table->mask)
+	{
+		/* a slot freed and taken again since the key was read holds another program */
+		if(key == program && (info = (glcProgramInfo*)GLC_LOAD_POINTER(&table->infos[i]))->program == program)
+		{
+			glc_lastKey = program;
+			glc_lastProgram = info;
+			glc_lastGeneration = generation;
+			return info;
+		}
+	}
+	return NULL;
+}
+
+/* Returns 1 and the slot of a program in a table, or 0 and the slot it
+   would go to. Writers only. */
+static int glc_probeProgram(const glcProgramTable* table, GLuint program, unsigned int* slot)
+{
+	unsigned int i;
+
+	*slot = ~0u;
+	for(i = glc_hashProgram(program) & table->mask; table->keys[i]; i = (i + 1) & table->mask)
+	{
+		if(table->keys[i] == program)
+		{
+			*slot = i;
+			return 1;
+		}
+		if(table->keys[i] == GLC_UNKNOWN_PROGRAM && *slot == ~0u)
+			*slot = i;
+	}
+	if(*slot == ~0u)
+		*slot = i;
+	return 0;
+}
+
+/* Publishes a new table holding the live programs, sized for them to fill
+   at most a quarter of it. Writers only. */
+static int glc_rehashPrograms(void)
+{
+	unsigned int i, j, capacity = 16;
+	glcProgramTable* old = glc_programs;
+	glcProgramTable* table;
+
+	while((unsigned int)(glc_programCount + 1) * 4 > capacity)
+		capacity *= 2;
+	table = (glcProgramTable*)calloc(1, sizeof(glcProgramTable) + capacity * (sizeof(glcProgramInfo*) + sizeof(GLuint)));
+	if(!table)
+		return -1;
+	table->mask = capacity - 1;
+	table->infos = (glcProgramInfo**)(table + 1);
+	table->keys = (GLuint*)(table->infos + capacity);
+	table->retired = old;
+	glc_programSlots = 0;
+	for(i = 0; old && i <= old->mask; i++)
+	{
+		if(!old->keys[i] || old->keys[i] == GLC_UNKNOWN_PROGRAM)
+			continue;
+		for(j = glc_hashProgram(old->keys[i]) & table->mask; table->keys[j]; j = (j + 1) & table->mask);
+		table->infos[j] = old->infos[i];
+		table->keys[j] = old->keys[i];
+		glc_programSlots++;
+	}
+	GLC_STORE_POINTER(&glc_programs, table);
+	return 1;
+}
+
+/* Returns 1 (inserted), 0 (the program is known already, info was not
+   taken) or -1 (out of memory). */
+static int glc_insertProgram(glcProgramInfo* info)
+{
+	unsigned int i;
+	int result = 1;
+
+	GLC_LOCK(&glc_shareLock);
+	if(glc_programs && glc_probeProgram(glc_programs, info->program, &i))
+		result = 0;
+	else if(!glc_programs || (!glc_programs->keys[i] && (glc_programSlots + 1) * 2 > glc_programs->mask + 1))
+	{
+		if(glc_rehashPrograms() == -1)
+			result = -1;
+		else
+			glc_probeProgram(glc_programs, info->program, &i);
+	}
+	if(result == 1)
+	{
+		if(!glc_programs->keys[i])
+			glc_programSlots++;
+		GLC_STORE_POINTER(&glc_programs->infos[i], info);
+		GLC_STORE_INT(&glc_programs->keys[i], info->program);
+		glc_programCount++;
+	}
+	GLC_UNLOCK(&glc_shareLock);
+	return result;
+}
+
+/* Undoes what a program adds to the shared counters and deletes the shaders
+   of an unfinished build, leaving the memory to glc_freeProgramMemory. */
+static void glc_releaseProgramInfo(glcProgramInfo* info)
+{
+	int i;
+
+	if(info->uniformMode)
+		GLC_ADD_INT(&glc_uniformHooks, -1);
+	if(info->pending)
+	{
+		for(i = 0; i < info->pendingCount; i++)
+			glDeleteShader(info->pendingShaders[i]);
+		GLC_ADD_INT(&glc_pendingPrograms, -1);
+	}
+	info->uniformMode = 0;
+	info->pending = GL_FALSE;
+}
+
+static void glc_freeProgramMemory(glcProgramInfo* info)
+{
+	free(info->uniforms);
+	free(info->names);
+	free(info->resources);
+	free(info->resourceNames);
+	free(info->locationResources);
+	free(info->slotOffsets);
+	free(info->shadow);
+	free(info);
+}
+
+static void glc_freeProgramInfo(glcProgramInfo* info)
+{
+	glc_releaseProgramInfo(info);
+	glc_freeProgramMemory(info);
+}
+
+static void glc_removeProgram(GLuint program)
+{
+	unsigned int i;
+	int retire = 0;
+	glcProgramInfo* info = NULL;
+
+	GLC_LOCK(&glc_shareLock);
+	if(glc_programs && glc_probeProgram(glc_programs, program, &i))
+	{
+		info = glc_programs->infos[i];
+		GLC_STORE_INT(&glc_programs->keys[i], GLC_UNKNOWN_PROGRAM);
+		GLC_ADD_INT(&glc_programGeneration, 1);
+		glc_programCount--;
+		/* lookups on other threads may still be reading it */
+		if((retire = GLC_LOAD_INT(&glc_threadContexts)))
+		{
+			info->retired = glc_retiredPrograms;
+			glc_retiredPrograms = info;
+		}
+	}
+	GLC_UNLOCK(&glc_shareLock);
+	if(!info)
+		return;
+	glc_releaseProgramInfo(info);
+	if(!retire)
+		glc_freeProgramMemory(info);
+}
+
+/*	glcFreeRetiredPrograms()
+	Frees what glc kept for programs deleted since any thread made a context
+	of its own current. Call it at a point where no other thread is inside
+	glc, such as between frames while the workers are idle. */
+void glcFreeRetiredPrograms(void)
+{
+	glcProgramInfo* info, *next;
+
+	GLC_LOCK(&glc_shareLock);
+	info = glc_retiredPrograms;
+	glc_retiredPrograms = NULL;
+	GLC_UNLOCK(&glc_shareLock);
+	for(; info; info = next)
+	{
+		next = info->retired;
+		glc_freeProgramMemory(info);
+	}
+}
+
+static int glc_growUniformTable(glcProgramInfo* info)
+{
+	int i, newCapacity = info->uniformCapacity ? info->uniformCapacity * 2 : 32;
+	unsigned int j, mask = (unsigned int)newCapacity - 1;
+	glcUniformEntry* table = (glcUniformEntry*)malloc(newCapacity * sizeof(glcUniformEntry));
+
+	if(!table)
+		return -1;
+	for(i = 0; i < newCapacity; i++)
+		table[i].name = -1;
+	for(i = 0; i < info->uniformCapacity; i++)
+	{
+		if(info->uniforms[i].name < 0)
+			continue;
+		for(j = info->uniforms[i].hash & mask; table[j].name >= 0; j = (j + 1) & mask);
+		table[j] = info->uniforms[i];
+	}
+	free(info->uniforms);
+	info->uniforms = table;
+	info->uniformCapacity = newCapacity;
+	return 1;
+}
+
+static int glc_addUniform(glcProgramInfo* info, const char* name, GLint location)
+{
+	unsigned int i, mask, hash = glc_hashString(name);
+	int length = (int)strlen(name) + 1;
+
+	if((info->uniformCount + 1) * 2 > info->uniformCapacity && glc_growUniformTable(info) == -1)
+		return -1;
+	if(info->namesLength + length > info->namesCapacity)
+	{
+		int newCapacity = info->namesCapacity ? info->namesCapacity : 256;
+		char* names;
+		while(newCapacity < info->namesLength + length)
+			newCapacity *= 2;
+		if(!(names = (char*)realloc(info->names, newCapacity)))
+			return -1;
+		info->names = names;
+		info->namesCapacity = newCapacity;
+	}
+	memcpy(info->names + info->namesLength, name, length);
+	mask = (unsigned int)info->uniformCapacity - 1;
+	for(i = hash & mask; info->uniforms[i].name >= 0; i = (i + 1) & mask);
+	info->uniforms[i].hash = hash;
+	info->uniforms[i].name = info->namesLength;
+	info->uniforms[i].location = location;
+	info->namesLength += length;
+	info->uniformCount++;
+	return 1;
+}
+
+/* Registers a uniform under its name, and an array of basic types also under
+   its base name and under each element name "name[i]". name has room for an
+   element suffix of up to 10 digits. elements receives the location of each
+   of the size elements, -1 for those without one. */
+static int glc_addUniformNames(glcProgramInfo* info, char* name, int length, GLint size, GLint location, int consecutive, GLint* elements)
+{
+	int j;
+
+	elements[0] = location;
+	for(j = 1; j < size; j++)
+		elements[j] = -1;
+	if(glc_addUniform(info, name, location) == -1)
+		return -1;
+	if(length < 4 || strcmp(name + length - 3, "[0]"))
+		return 1;
+	name[length - 3] = '\0';
+	if(glc_addUniform(info, name, location) == -1)
+		return -1;
+	for(j = 1; j < size; j++)
+	{
+		sprintf(name + length - 3, "[%d]", j);
+		/* element locations are guaranteed consecutive from GL 4.3 on */
+		elements[j] = consecutive ? location + j : glGetUniformLocation(info->program, name);
+		if(elements[j] != -1 && glc_addUniform(info, name, elements[j]) == -1)
+			return -1;
+	}
+	return 1;
+}
+
+/* Allocates room for count resources and names of up to namesSize bytes. */
+static int glc_allocResources(glcProgramInfo* info, int count, size_t namesSize)
+{
+	info->resources = (glcProgramResource*)calloc(count + 1, sizeof(glcProgramResource));
+	info->resourceNames = (char*)malloc(namesSize + 1);
+	return (info->resources && info->resourceNames) ? 1 : -1;
+}
+
+static int glc_hasExtension(const char* name);
+
+#if defined(GL_VERSION_4_3) || defined(GL_ARB_program_interface_query)
+static const GLenum glc_resourceInterfaces[GLC_RESOURCE_INTERFACES] =
+{
+	GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK, GL_UNIFORM, GL_PROGRAM_INPUT, GL_PROGRAM_OUTPUT
+};
+
+/* Fills the reflection through the program interface queries. Blocks come
+   first, so a uniform's block index is its block's resource index. name
+   receives a buffer for the longest name plus an element suffix. */
+static int glc_queryResources(glcProgramInfo* info, char** name)
+{
+	int i, k, namesLength = 0;
+	GLint counts[GLC_RESOURCE_INTERFACES], length, maxLength = 0, total = 0, values[5];
+	size_t namesSize = 0;
+	const GLenum blockProperties[3] = { GL_NAME_LENGTH, GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+	const GLenum variableProperties[5] = { GL_NAME_LENGTH, GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION, GL_BLOCK_INDEX };
+	glcProgramResource* r;
+
+	for(k = 0; k < GLC_RESOURCE_INTERFACES; k++)
+	{
+		counts[k] = length = 0;
+		glGetProgramInterfaceiv(info->program, glc_resourceInterfaces[k], GL_ACTIVE_RESOURCES, &counts[k]);
+		glGetProgramInterfaceiv(info->program, glc_resourceInterfaces[k], GL_MAX_NAME_LENGTH, &length);
+		total += counts[k];
+		namesSize += (size_t)counts[k] * (length + 1);
+		if(length > maxLength)
+			maxLength = length;
+	}
+	if(glc_allocResources(info, total, namesSize) == -1 || !(*name = (char*)malloc(maxLength + 16)))
+		return -1;
+	r = info->resources;
+	for(k = 0; k < GLC_RESOURCE_INTERFACES; k++)
+	{
+		for(i = 0; i < counts[k]; i++, r++)
+		{
+			r->interface = k;
+			r->location = r->block = -1;
+			if(k <= GLC_RESOURCE_STORAGE_BLOCK)
+			{
+				glGetProgramResourceiv(info->program, glc_resourceInterfaces[k], (GLuint)i, 3, blockProperties, 3, NULL, values);
+				r->size = 1;
+				r->binding = values[1];
+				r->dataSize = values[2];
+			}
+			else
+			{
+				glGetProgramResourceiv(info->program, glc_resourceInterfaces[k], (GLuint)i,
+					(k == GLC_RESOURCE_UNIFORM) ? 5 : 4, variableProperties, 5, NULL, values);
+				r->type = (GLenum)values[1];
+				r->size = values[2];
+				r->location = values[3];
+				if(k == GLC_RESOURCE_UNIFORM && values[4] >= 0)
+					r->block = values[4];
+			}
+			length = 0;
+			glGetProgramResourceName(info->program, glc_resourceInterfaces[k], (GLuint)i, values[0], &length, info->resourceNames + namesLength);
+			r->name = info->resourceNames + namesLength;
+			namesLength += length + 1;
+			info->resourceCount++;
+		}
+	}
+	return 1;
+}
+#endif
+
+/* Fills the reflection from glGetActiveUniform and glGetActiveAttrib, as
+   glc_queryResources does. */
+static int glc_queryActiveUniforms(glcProgramInfo* info, char** name)
+{
+	int i, k, namesLength = 0;
+	GLint counts[2] = {0, 0}, maxLengths[2] = {0, 0}, length, size;
+	GLenum type;
+	glcProgramResource* r;
+
+	glGetProgramiv(info->program, GL_ACTIVE_UNIFORMS, &counts[0]);
+	glGetProgramiv(info->program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLengths[0]);
+	glGetProgramiv(info->program, GL_ACTIVE_ATTRIBUTES, &counts[1]);
+	glGetProgramiv(info->program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLengths[1]);
+	if(glc_allocResources(info, counts[0] + counts[1], (size_t)counts[0] * (maxLengths[0] + 1) + (size_t)counts[1] * (maxLengths[1] + 1)) == -1 ||
+		!(*name = (char*)malloc((maxLengths[0] > maxLengths[1] ? maxLengths[0] : maxLengths[1]) + 16)))
+		return -1;
+	r = info->resources;
+	for(k = 0; k < 2; k++)
+	{
+		for(i = 0; i < counts[k]; i++, r++)
+		{
+			length = 0;
+			if(!k)
+				glGetActiveUniform(info->program, (GLuint)i, maxLengths[k], &length, &size, &type, *name);
+			else
+				glGetActiveAttrib(info->program, (GLuint)i, maxLengths[k], &length, &size, &type, *name);
+			memcpy(info->resourceNames + namesLength, *name, length + 1);
+			r->name = info->resourceNames + namesLength;
+			namesLength += length + 1;
+			r->interface = k ? GLC_RESOURCE_INPUT : GLC_RESOURCE_UNIFORM;
+			r->type = type;
+			r->size = size;
+			r->block = -1;
+			/* uniforms living in a uniform block have no location */
+			r->location = k ? glGetAttribLocation(info->program, *name) : glGetUniformLocation(info->program, *name);
+			info->resourceCount++;
+		}
+	}
+	return 1;
+}
+
+/* Gathers the reflection of a linked program and the uniform name table,
+   replacing what was there. */
+static int glc_reflectProgram(glcProgramInfo* info)
+{
+	int i, j, result, elementCount = 0;
+	GLint maxLocation = -1, *elements = NULL, *element;
+	char* name = NULL;
+	glcProgramResource* r;
+	glcContext* context = glc_getContext();
+
+	info->uniformCount = 0;
+	info->namesLength = 0;
+	for(i = 0; i < info->uniformCapacity; i++)
+		info->uniforms[i].name = -1;
+	free(info->resources);
+	free(info->resourceNames);
+	free(info->locationResources);
+	info->resources = NULL;
+	info->resourceNames = NULL;
+	info->locationResources = NULL;
+	info->locationNext = NULL;
+	info->resourceCount = 0;
+	info->locationCount = 0;
+
+	if(context->programInterface == -1)
+	{
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		context->programInterface = (major > 4 || (major == 4 && minor >= 3)) ? 2 : glc_hasExtension("GL_ARB_program_interface_query");
+	}
+#if defined(GL_VERSION_4_3) || defined(GL_ARB_program_interface_query)
+	if(context->programInterface)
+		result = glc_queryResources(info, &name);
+	else
+#endif
+		result = glc_queryActiveUniforms(info, &name);
+	for(i = 0, r = info->resources; result == 1 && i < info->resourceCount; i++, r++)
+	{
+		if(r->interface == GLC_RESOURCE_UNIFORM && r->location != -1)
+			elementCount += r->size;
+	}
+	if(result == 1 && elementCount && !(elements = (GLint*)malloc(elementCount * sizeof(GLint))))
+		result = -1;
+
+	/* name every uniform and find where each of its elements lives */
+	for(i = 0, r = info->resources, element = elements; result == 1 && i < info->resourceCount; i++, r++)
+	{
+		if(r->interface != GLC_RESOURCE_UNIFORM || r->location == -1)
+			continue;
+		memcpy(name, r->name, strlen(r->name) + 1);
+		result = glc_addUniformNames(info, name, (int)strlen(name), r->size, r->location, context->programInterface == 2, element);
+		for(j = 0; j < r->size; j++)
+		{
+			if(element[j] > maxLocation)
+				maxLocation = element[j];
+		}
+		element += r->size;
+	}
+	free(name);
+
+	/* map every uniform location back to its declaration and the next element */
+	if(result == 1 && maxLocation >= 0 && !(info->locationResources = (int*)malloc((maxLocation + 1) * 2 * sizeof(int))))
+		result = -1;
+	if(result == 1 && maxLocation >= 0)
+	{
+		info->locationNext = info->locationResources + maxLocation + 1;
+		for(i = 0; i <= maxLocation; i++)
+			info->locationResources[i] = info->locationNext[i] = -1;
+		for(i = 0, r = info->resources, element = elements; i < info->resourceCount; i++, r++)
+		{
+			if(r->interface != GLC_RESOURCE_UNIFORM || r->location == -1)
+				continue;
+			for(j = 0; j < r->size; j++)
+			{
+				if(element[j] == -1)
+					continue;
+				info->locationResources[element[j]] = i;
+				info->locationNext[element[j]] = (j + 1 < r->size) ? element[j + 1] : -1;
+			}
+			element += r->size;
+		}
+		info->locationCount = maxLocation + 1;
+	}
+	free(elements);
+	return result;
+}
+
+/* Returns the location of the array element count elements after the one at
+   location, or -1 past the end of the array. */
+static GLint glc_elementLocation(const glcProgramInfo* info, GLint location, int count)
+{
+	for(; count > 0 && location >= 0 && location < info->locationCount; count--)
+		location = info->locationNext[location];
+	return count ? -1 : location;
+}
+
+/* Returns the cache entry for a program, building it on first use.
+   Returns NULL if the program is not linked or memory ran out. */
+static glcProgramInfo* glc_getProgram(GLuint program)
+{
+	int inserted;
+	GLint linked = 0;
+	glcProgramInfo* info;
+
+	if((info = glc_findProgram(program)))
+	{
+		if(info->pending && glcFinishShaderProgram(program) == -1)
+			return NULL;
+		return info;
+	}
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if(!linked)
+		return NULL;
+	if(!(info = (glcProgramInfo*)calloc(1, sizeof(glcProgramInfo))))
+		return NULL;
+	info->program = program;
+	if(glc_reflectProgram(info) == -1 || (inserted = glc_insertProgram(info)) == -1)
+	{
+		glc_freeProgramInfo(info);
+		return NULL;
+	}
+	/* another thread got there first */
+	if(!inserted)
+	{
+		glc_freeProgramInfo(info);
+		info = glc_findProgram(program);
+	}
+	return info;
+}
+
+/*	glcGetUniformLocation()
+	Returns: location of the uniform, or -1 if it is not an active uniform
+	program - shader program handle
+	name - name of uniform */
+GLint glcGetUniformLocation(GLuint program, const char* name)
+{
+	unsigned int i, mask, hash;
+	glcProgramInfo* info = glc_getProgram(program);
+
+	GLC_STAT(frame.locationLookups++);
+	if(!info)
+	{
+		GLC_STAT(frame.driverLookups++);
+		return glGetUniformLocation(program, name);
+	}
+	if(!info->uniformCount)
+		return -1;
+	hash = glc_hashString(name);
+	mask = (unsigned int)info->uniformCapacity - 1;
+	for(i = hash & mask; info->uniforms[i].name >= 0; i = (i + 1) & mask)
+	{
+		if(info->uniforms[i].hash == hash && !strcmp(info->names + info->uniforms[i].name, name))
+			return info->uniforms[i].location;
+	}
+	return -1;
+}
+
+/*	glcGetProgramResources()
+	Returns: amount of resources, or -1 if the program is not linked
+	program - shader program handle
+	resources - receives the program's reflection, valid until the program is
+		relinked or deleted */
+int glcGetProgramResources(GLuint program, const glcProgramResource** resources)
+{
+	glcProgramInfo* info = glc_getProgram(program);
+
+	*resources = NULL;
+	if(!info)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Program %u is not linked.", program);
+		return -1;
+	}
+	*resources = info->resources;
+	return info->resourceCount;
+}
+
+/*	glcFindProgramResource()
+	Returns: the resource, or NULL if the program has no such active resource
+	program - shader program handle
+	interface - GLC_RESOURCE_UNIFORM, GLC_RESOURCE_INPUT, ...
+	name - resource name, arrays of basic types with or without their [0]
+		suffix. For uniforms, also an array element "name[i]". */
+const glcProgramResource* glcFindProgramResource(GLuint program, int interface, const char* name)
+{
+	int i;
+	size_t length = strlen(name);
+	GLint location;
+	glcProgramInfo* info;
+
+	if(interface == GLC_RESOURCE_UNIFORM && (location = glcGetUniformLocation(program, name)) != -1)
+	{
+		info = glc_findProgram(program);
+		return (info && location < info->locationCount && info->locationResources[location] != -1) ?
+			&info->resources[info->locationResources[location]] : NULL;
+	}
+	if(!(info = glc_getProgram(program)))
+		return NULL;
+	/* block members and everything else */
+	for(i = 0; i < info->resourceCount; i++)
+	{
+		const char* resource = info->resources[i].name;
+		if(info->resources[i].interface == interface && !strncmp(resource, name, length) &&
+			(resource[length] == '\0' || !strcmp(resource + length, "[0]")))
+			return &info->resources[i];
+	}
+	return NULL;
+}
+
+static int glc_buildShadow(glcProgramInfo* info);
+
+/*	glcCacheUniformLocations()
+	Returns: 1 (success) or -1 (failure)
+	program - linked shader program handle
+	Rebuilds the location cache of a program. glcMakeShaderProgram does this
+	automatically; call it after relinking a program yourself. */
+int glcCacheUniformLocations(GLuint program)
+{
+	glcProgramInfo* info = glc_findProgram(program);
+
+	if(!info)
+		return glc_getProgram(program) ? 1 : -1;
+	if(glc_reflectProgram(info) == -1)
+	{
+		GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when caching uniform locations.");
+		glc_removeProgram(program);
+		return -1;
+	}
+	/* relinking reset every uniform, so the shadow values are stale */
+	if(info->uniformMode && glc_buildShadow(info) == -1)
+	{
+		glc_removeProgram(program);
+		return -1;
+	}
+	return 1;
+}
+
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_separate_shader_objects)
+static void glc_releasePipelines(GLuint program);
+#endif
+
+/*	glcDeleteShaderProgram()
+	program - shader program handle
+	Deletes the program and drops everything glc has cached for it, including
+	the pipelines glcGetProgramPipeline assembled from it. */
+void glcDeleteShaderProgram(GLuint program)
+{
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_separate_shader_objects)
+	glcProgramInfo* info = glc_findProgram(program);
+#endif
+
+	/* a deleted program stays in use until unbound, and its name can be reused */
+	if(program == glc_getContext()->currentProgram)
+		glc_getContext()->currentProgram = GLC_UNKNOWN_PROGRAM;
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_separate_shader_objects)
+	if(info && info->separableStages)
+		glc_releasePipelines(program);
+#endif
+	glc_removeProgram(program);
+	glDeleteProgram(program);
+}
+
+/*	Program binary cache
+	With a cache directory set through glcSetProgramBinaryCache(),
+	glcMakeShaderProgram stores every program it links as a driver binary
+	(glGetProgramBinary, GL 4.1 / ARB_get_program_binary) and on later runs
+	loads it back with glProgramBinary instead of compiling. Files are named
+	after a 64 bit hash of the shader sources and the GL vendor, renderer and
+	version strings, so a driver update or an edited shader simply misses.
+	A binary the driver rejects falls back to a normal compile and is
+	replaced on disk. */
+#define GLC_BINARY_MAGIC 0x42434c47u	/* "GLCB" */
+
+typedef struct glcBinaryHeader
+{
+	unsigned int magic;
+	unsigned int format;
+	unsigned int length;
+	unsigned int keyLow, keyHigh;
+} glcBinaryHeader;
+
+static char* glc_binaryCachePath = NULL;
+
+/* FNV-1a, 64 bit */
+static unsigned long long glc_hashBytes(unsigned long long hash, const void* data, size_t length)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	while(length--)
+	{
+		hash ^= *bytes++;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static unsigned long long glc_binaryKey(const GLenum* types, const char* const* sources, const GLint* lengths, int count)
+{
+	int i;
+	const GLenum strings[3] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+	unsigned long long hash = 14695981039346656037ull;
+
+	for(i = 0; i < 3; i++)
+	{
+		const char* string = (const char*)glGetString(strings[i]);
+		if(string)
+			hash = glc_hashBytes(hash, string, strlen(string) + 1);
+	}
+	for(i = 0; i < count; i++)
+	{
+		hash = glc_hashBytes(hash, &types[i], sizeof(GLenum));
+		hash = glc_hashBytes(hash, &lengths[i], sizeof(GLint));
+		hash = glc_hashBytes(hash, sources[i], lengths[i]);
+	}
+	return hash;
+}
+
+/* Writes the cache file name of a key into path, which holds at least
+   strlen(glc_binaryCachePath) + 32 characters. */
+static void glc_binaryPath(char* path, unsigned long long key)
+{
+	sprintf(path, "%s/%08x%08x.bin", glc_binaryCachePath,
+		(unsigned int)(key >> 32), (unsigned int)key);
+}
+
+/*	glcSetProgramBinaryCache()
+	Returns: 1 (success) or -1 (failure)
+	directory - existing directory to keep program binaries in,
+		or NULL to turn the cache off */
+int glcSetProgramBinaryCache(const char* directory)
+{
+	free(glc_binaryCachePath);
+	glc_binaryCachePath = NULL;
+	if(!directory)
+		return 1;
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_get_program_binary)
+	if(!(glc_binaryCachePath = (char*)malloc(strlen(directory) + 1)))
+	{
+		GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when setting program binary cache.");
+		return -1;
+	}
+	strcpy(glc_binaryCachePath, directory);
+	return 1;
+#else
+	GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Program binary cache requires OpenGL 4.1 or ARB_get_program_binary.");
+	return -1;
+#endif
+}
+
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_get_program_binary)
+
+/* Returns 1 and a linked program if the cache held a binary the driver
+   accepted for this key, -1 otherwise. */
+static int glc_loadProgramBinary(GLuint* program, unsigned long long key, GLboolean separable)
+{
+	int success = 0;
+	char* path;
+	void* data = NULL;
+	FILE* file;
+	glcBinaryHeader header;
+
+	if(!glc_binaryCachePath || !(path = (char*)malloc(strlen(glc_binaryCachePath) + 32)))
+		return -1;
+	glc_binaryPath(path, key);
+	file = fopen(path, "rb");
+	free(path);
+	if(!file)
+		return -1;
+	if(fread(&header, sizeof(header), 1, file) == 1 && header.magic == GLC_BINARY_MAGIC &&
+		header.keyLow == (unsigned int)key && header.keyHigh == (unsigned int)(key >> 32) &&
+		(data = malloc(header.length)) && fread(data, 1, header.length, file) == header.length)
+	{
+		if((*program = glCreateProgram()))
+		{
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_separate_shader_objects)
+			if(separable)
+				glProgramParameteri(*program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+#endif
+			glProgramBinary(*program, (GLenum)header.format, data, (GLsizei)header.length);
+			glGetProgramiv(*program, GL_LINK_STATUS, &success);
+			if(!success)
+				glDeleteProgram(*program);
+		}
+	}
+	fclose(file);
+	free(data);
+	return success ? 1 : -1;
+}
+
+/* Stores the binary of a freshly linked program. Failing to do so only
+   costs a compile next run, so errors are not reported. */
+static void glc_saveProgramBinary(GLuint program, unsigned long long key)
+{
+	GLint length = 0;
+	GLenum format;
+	char* path, *temp;
+	void* data;
+	FILE* file;
+	glcBinaryHeader header;
+
+	if(!glc_binaryCachePath)
+		return;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if(length <= 0)
+		return;
+	data = malloc(length);
+	path = (char*)malloc(2 * (strlen(glc_binaryCachePath) + 32));
+	if(!data || !path)
+	{
+		free(data);
+		free(path);
+		return;
+	}
+	temp = path + strlen(glc_binaryCachePath) + 32;
+	glGetProgramBinary(program, length, &length, &format, data);
+	header.magic = GLC_BINARY_MAGIC;
+	header.format = (unsigned int)format;
+	header.length = (unsigned int)length;
+	header.keyLow = (unsigned int)key;
+	header.keyHigh = (unsigned int)(key >> 32);
+	glc_binaryPath(path, key);
+	glc_binaryPath(temp, key);
+	strcat(temp, ".tmp");
+	/* write aside and rename, so a crash never leaves a torn binary */
+	if((file = fopen(temp, "wb")))
+	{
+		int written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+			fwrite(data, 1, length, file) == (size_t)length;
+		if(fclose(file) == 0 && written)
+		{
+			remove(path);
+			rename(temp, path);
+		}
+		else
+			remove(temp);
+	}
+	free(data);
+	free(path);
+}
+
+#endif
+
+/*	glcLoadShaderSource()
+	Returns: 1 (success) or -1 (failure)
+	path - path to shader source code file
+	source - receives the null terminated file contents, release with free()
+	length - receives the length of the source, without the terminator
+	The file is sized with one seek and read with one fread. */
+int glcLoadShaderSource(const char* path, char** source, GLint* length)
+{
+	long size;
+	FILE* file;
+#ifdef GLC_STATS
+	double start = glc_seconds();
+#endif
+
+	*source = NULL;
+	*length = 0;
+	if(!(file = fopen(path, "rb")))
+	{
+		GLC_LOG(GLC_ERROR_FILE, "Error opening shader: %s", path);
+		return -1;
+	}
+	if(fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0)
+	{
+		GLC_LOG(GLC_ERROR_FILE, "Error sizing shader: %s", path);
+		fclose(file);
+		return -1;
+	}
+	if(!(*source = (char*)malloc(size + 1)))
+	{
+		GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when loading shader: %s", path);
+		fclose(file);
+		return -1;
+	}
+	if(fread(*source, 1, size, file) != (size_t)size)
+	{
+		GLC_LOG(GLC_ERROR_FILE, "Error reading shader: %s", path);
+		fclose(file);
+		free(*source);
+		*source = NULL;
+		return -1;
+	}
+	fclose(file);
+	(*source)[size] = '\0';
+	*length = (GLint)size;
+	GLC_STAT(fileTime += glc_seconds() - start);
+	return 1;
+}
+
+/*	Asynchronous program builds
+	glcBeginShaderProgram() hands both shaders and the link to the driver
+	without asking for any status, so nothing waits on the compiler. With
+	GL_KHR_parallel_shader_compile (or the ARB version) the driver compiles on
+	its own threads and glcShaderProgramReady() polls GL_COMPLETION_STATUS_KHR;
+	otherwise the work happens at the first status query. A pending program
+	is finished by glcFinishShaderProgram(), or implicitly the first time it
+	is bound through glcUseProgram or has a uniform looked up. */
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+static int glc_hasExtension(const char* name)
+{
+	GLint i, count = 0;
+
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for(i = 0; i < count; i++)
+	{
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+		if(extension && !strcmp(extension, name))
+			return 1;
+	}
+	return 0;
+}
+
+static void glc_initParallelCompile(void)
+{
+	glcContext* context = glc_getContext();
+
+	if(context->parallelCompile != -1)
+		return;
+	context->parallelCompile = 0;
+	if(glc_hasExtension("GL_KHR_parallel_shader_compile"))
+	{
+		context->parallelCompile = 1;
+#ifdef GL_KHR_parallel_shader_compile
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+#endif
+	}
+	else if(glc_hasExtension("GL_ARB_parallel_shader_compile"))
+	{
+		context->parallelCompile = 1;
+#ifdef GL_ARB_parallel_shader_compile
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+#endif
+	}
+}
+
+/*	Program builder
+	glcBeginProgram() and glcMakeProgram() build a program from any set of
+	stages: vertex, tessellation, geometry and fragment shaders, or a single
+	compute shader. Each stage comes from a file or from memory, as GLSL or
+	as a SPIR-V module (GL 4.6 or ARB_gl_spirv), told apart by the SPIR-V
+	magic number; give in-memory modules their length. SPIR-V skips parsing
+	GLSL at startup, see tools/glc_spirv.c for compiling to it offline. Its
+	entry point must be main, and since drivers need not keep the names of a
+	SPIR-V program, give its uniforms explicit locations and look them up by
+	location. Builds go through the program binary cache and the
+	asynchronous path above, and every other glcMake/glcBegin function is a
+	shorthand for these. */
+typedef struct glcShaderStage
+{
+	GLenum type;		/* GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_COMPUTE_SHADER, ... */
+	const char* path;	/* source code file, or NULL to use source */
+	const char* source;
+	GLint length;		/* length of source, or -1 if null terminated */
+} glcShaderStage;
+
+#ifndef GLC_NO_DIAGNOSTICS
+static const char* glc_stageName(GLenum type, int capital)
+{
+	switch(type)
+	{
+	case GL_VERTEX_SHADER:			return capital ? "Vertex" : "vertex";
+	case GL_FRAGMENT_SHADER:		return capital ? "Fragment" : "fragment";
+#ifdef GL_GEOMETRY_SHADER
+	case GL_GEOMETRY_SHADER:		return capital ? "Geometry" : "geometry";
+#endif
+#ifdef GL_TESS_CONTROL_SHADER
+	case GL_TESS_CONTROL_SHADER:	return capital ? "Tessellation control" : "tessellation control";
+	case GL_TESS_EVALUATION_SHADER:	return capital ? "Tessellation evaluation" : "tessellation evaluation";
+#endif
+#ifdef GL_COMPUTE_SHADER
+	case GL_COMPUTE_SHADER:			return capital ? "Compute" : "compute";
+#endif
+	default:						return capital ? "Unknown" : "unknown";
+	}
+}
+#endif
+
+static GLbitfield glc_stageBit(GLenum type)
+{
+	switch(type)
+	{
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_separate_shader_objects)
+	case GL_VERTEX_SHADER:			return GL_VERTEX_SHADER_BIT;
+	case GL_FRAGMENT_SHADER:		return GL_FRAGMENT_SHADER_BIT;
+	case GL_GEOMETRY_SHADER:		return GL_GEOMETRY_SHADER_BIT;
+	case GL_TESS_CONTROL_SHADER:	return GL_TESS_CONTROL_SHADER_BIT;
+	case GL_TESS_EVALUATION_SHADER:	return GL_TESS_EVALUATION_SHADER_BIT;
+#endif
+#if defined(GL_VERSION_4_3) || defined(GL_ARB_compute_shader)
+	case GL_COMPUTE_SHADER:			return GL_COMPUTE_SHADER_BIT;
+#endif
+	default:						return 0;
+	}
+}
+
+#define GLC_SPIRV_MAGIC 0x07230203u
+
+#if defined(GL_VERSION_4_6)
+#define GLC_SPIRV_FORMAT GL_SHADER_BINARY_FORMAT_SPIR_V
+#define glc_specializeShader glSpecializeShader
+#elif defined(GL_ARB_gl_spirv)
+#define GLC_SPIRV_FORMAT GL_SHADER_BINARY_FORMAT_SPIR_V_ARB
+#define glc_specializeShader glSpecializeShaderARB
+#endif
+
+/* A SPIR-V module starts with a five word header, the first the magic. */
+static int glc_isSpirv(const char* source, GLint length)
+{
+	unsigned int magic;
+
+	if(length < 20 || length % 4)
+		return 0;
+	memcpy(&magic, source, sizeof(magic));
+	return magic == GLC_SPIRV_MAGIC;
+}
+
+/* Hands GLSL source or a SPIR-V module to a shader object. Either way the
+   outcome shows in the shader's compile status; returns -1 only if the
+   driver takes no SPIR-V. */
+static int glc_compileShader(GLuint shader, const char* source, GLint length)
+{
+#ifdef GLC_SPIRV_FORMAT
+	glcContext* context = glc_getContext();
+#endif
+
+	if(!glc_isSpirv(source, length))
+	{
+		glShaderSource(shader, 1, &source, &length);
+		glCompileShader(shader);
+		return 1;
+	}
+#ifdef GLC_SPIRV_FORMAT
+	if(context->spirv == -1)
+	{
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		context->spirv = (major > 4 || (major == 4 && minor >= 6)) || glc_hasExtension("GL_ARB_gl_spirv");
+	}
+	if(context->spirv)
+	{
+		glShaderBinary(1, &shader, GLC_SPIRV_FORMAT, source, length);
+		/* specialising is what compiles a SPIR-V shader */
+		glc_specializeShader(shader, "main", 0, NULL, NULL);
+		return 1;
+	}
+#endif
+	GLC_LOG(GLC_ERROR_INVALID_OPERATION, "SPIR-V shaders need OpenGL 4.6 or ARB_gl_spirv.");
+	return -1;
+}
+
+static int glc_beginProgram(GLuint* program, const glcShaderStage* stages, int count, GLboolean separable)
+{
+	int i, result = -1;
+	GLbitfield stageBits = 0;
+	GLenum types[GLC_MAX_SHADER_STAGES];
+	GLint lengths[GLC_MAX_SHADER_STAGES];
+	const char* sources[GLC_MAX_SHADER_STAGES];
+	char* loaded[GLC_MAX_SHADER_STAGES] = {NULL};
+	GLuint shaders[GLC_MAX_SHADER_STAGES] = {0};
+	glcProgramInfo* info = NULL;
+	unsigned long long key = 0;
+#ifdef GLC_STATS
+	double start;
+#endif
+
+	if(count < 1 || count > GLC_MAX_SHADER_STAGES)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Stage count invalid. Must be 1-%d. Got %d.", GLC_MAX_SHADER_STAGES, count);
+		return -1;
+	}
+	*program = 0;
+	for(i = 0; i < count; i++)
+	{
+		types[i] = stages[i].type;
+		stageBits |= glc_stageBit(types[i]);
+		if(stages[i].path)
+		{
+			if(glcLoadShaderSource(stages[i].path, &loaded[i], &lengths[i]) == -1)
+				goto cleanup;
+			sources[i] = loaded[i];
+		}
+		else
+		{
+			sources[i] = stages[i].source;
+			lengths[i] = (stages[i].length < 0) ? (GLint)strlen(sources[i]) : stages[i].length;
+		}
+	}
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_get_program_binary)
+	if(glc_binaryCachePath)
+	{
+		key = glc_binaryKey(types, sources, lengths, count);
+		/* a separable binary is a different program */
+		if(separable)
+			key = glc_hashBytes(key, &separable, sizeof(separable));
+		if(glc_loadProgramBinary(program, key, separable) == 1)
+		{
+			GLC_STAT(binaryCacheHits++);
+			/* a name recycled from a program deleted behind glc's back */
+			glc_removeProgram(*program);
+			if((result = glcCacheUniformLocations(*program)) == 1 && (info = glc_findProgram(*program)))
+			{
+				info->binaryKey = key;
+				info->separableStages = separable ? stageBits : 0;
+				info = NULL;
+			}
+			goto cleanup;
+		}
+	}
+#endif
+	glc_initParallelCompile();
+#ifdef GLC_STATS
+	start = glc_seconds();
+#endif
+	/* Compile Shaders */
+	for(i = 0; i < count; i++)
+	{
+		if(!(shaders[i] = glCreateShader(types[i])))
+		{
+			GLC_LOG(GLC_ERROR_GL_OBJECT, "Error creating %s shader object.", glc_stageName(types[i], 0));
+			goto cleanup;
+		}
+		if(glc_compileShader(shaders[i], sources[i], lengths[i]) == -1)
+			goto cleanup;
+	}
+	GLC_STAT(compileTime += glc_seconds() - start);
+	/* Create Shader Program */
+	*program = glCreateProgram();
+	if(!(*program) || !(info = (glcProgramInfo*)calloc(1, sizeof(glcProgramInfo))))
+	{
+		GLC_LOG(GLC_ERROR_GL_OBJECT, "Error creating shader program object.");
+		goto cleanup;
+	}
+	for(i = 0; i < count; i++)
+		glAttachShader(*program, shaders[i]);
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_get_program_binary)
+	if(glc_binaryCachePath)
+		glProgramParameteri(*program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_separate_shader_objects)
+	if(separable)
+		glProgramParameteri(*program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+#endif
+#ifdef GLC_STATS
+	start = glc_seconds();
+#endif
+	glLinkProgram(*program);
+	GLC_STAT(linkTime += glc_seconds() - start);
+
+	/* a name recycled from a program deleted behind glc's back */
+	glc_removeProgram(*program);
+	info->program = *program;
+	info->pending = GL_TRUE;
+	info->pendingCount = count;
+	memcpy(info->pendingShaders, shaders, sizeof(shaders));
+	info->binaryKey = key;
+	info->separableStages = separable ? stageBits : 0;
+	/* counted first, a thread picking the program up may already finish it */
+	GLC_ADD_INT(&glc_pendingPrograms, 1);
+	if(glc_insertProgram(info) == -1)
+	{
+		GLC_ADD_INT(&glc_pendingPrograms, -1);
+		GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when creating shader program.");
+		goto cleanup;
+	}
+	info = NULL;
+	result = 1;
+
+cleanup:
+	for(i = 0; i < count; i++)
+	{
+		free(loaded[i]);
+		if(result == -1)
+			glDeleteShader(shaders[i]);
+	}
+	if(result == -1)
+	{
+		free(info);
+		glDeleteProgram(*program);
+		*program = 0;
+	}
+	return result;
+}
+
+/*	glcBeginProgram()
+	Returns: 1 (success) or -1 (failure)
+	program - pointer to a to be shader program handle
+	stages - the shader stages to link, 1 to GLC_MAX_SHADER_STAGES of them
+	count - amount of stages
+	Only file and object creation errors are reported here; compile and link
+	errors are reported by glcFinishShaderProgram. */
+int glcBeginProgram(GLuint* program, const glcShaderStage* stages, int count)
+{
+	return glc_beginProgram(program, stages, count, GL_FALSE);
+}
+
+/*	glcBeginShaderProgramSource()
+	Returns: 1 (success) or -1 (failure)
+	program - pointer to a to be shader program handle
+	vertexSource - vertex shader source code
+	vertexLength - length of vertexSource, or -1 if null terminated
+	fragmentSource - fragment shader source code
+	fragmentLength - length of fragmentSource, or -1 if null terminated
+	The sources are not referenced after the call returns. */
+int glcBeginShaderProgramSource(GLuint* program, const char* vertexSource, GLint vertexLength, const char* fragmentSource, GLint fragmentLength)
+{
+	glcShaderStage stages[2];
+
+	memset(stages, 0, sizeof(stages));
+	stages[0].type = GL_VERTEX_SHADER;
+	stages[0].source = vertexSource;
+	stages[0].length = vertexLength;
+	stages[1].type = GL_FRAGMENT_SHADER;
+	stages[1].source = fragmentSource;
+	stages[1].length = fragmentLength;
+	return glcBeginProgram(program, stages, 2);
+}
+
+/*	glcBeginShaderProgram()
+	Returns: 1 (success) or -1 (failure)
+	program - pointer to a to be shader program handle
+	vertexShaderPath - path to vertex shader source code file
+	fragmentShaderPath - path to fragment shader source code file
+	Only file and object creation errors are reported here; compile and link
+	errors are reported by glcFinishShaderProgram. */
+int glcBeginShaderProgram(GLuint* program, const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+	glcShaderStage stages[2];
+
+	memset(stages, 0, sizeof(stages));
+	stages[0].type = GL_VERTEX_SHADER;
+	stages[0].path = vertexShaderPath;
+	stages[1].type = GL_FRAGMENT_SHADER;
+	stages[1].path = fragmentShaderPath;
+	return glcBeginProgram(program, stages, 2);
+}
+
+/*	glcShaderProgramReady()
+	Returns: 1 if glcFinishShaderProgram will not wait, 0 if still building
+	program - shader program handle from glcBeginShaderProgram
+	Without parallel shader compile support this always returns 1, and
+	finishing does the whole build. */
+int glcShaderProgramReady(GLuint program)
+{
+	GLint done = GL_TRUE;
+	glcProgramInfo* info = glc_findProgram(program);
+
+	if(!info || !info->pending || glc_getContext()->parallelCompile != 1)
+		return 1;
+	glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &done);
+	return done ? 1 : 0;
+}
+
+/*	glcFinishShaderProgram()
+	Returns: 1 (success) or -1 (failure)
+	program - shader program handle from glcBeginShaderProgram
+	Waits for the build if needed and checks it. On failure the program and
+	its shaders are deleted. */
+int glcFinishShaderProgram(GLuint program)
+{
+	int i, success;
+	GLint type;
+	char* log;
+	glcProgramInfo* info = glc_findProgram(program);
+#ifdef GLC_STATS
+	double start = glc_seconds();
+#endif
+
+	if(!info || !info->pending)
+		return info ? 1 : -1;
+	info->pending = GL_FALSE;
+	GLC_ADD_INT(&glc_pendingPrograms, -1);
+	/* the first status query waits for the compile */
+	for(i = 0, success = 1; i < info->pendingCount && success; i++)
+	{
+		glGetShaderiv(info->pendingShaders[i], GL_COMPILE_STATUS, &success);
+		if(!success)
+		{
+			glGetShaderiv(info->pendingShaders[i], GL_SHADER_TYPE, &type);
+			log = glc_getInfoLog(info->pendingShaders[i], GL_FALSE);
+			GLC_LOG(GLC_ERROR_COMPILE, "%s shader compilation error!\n%s", glc_stageName((GLenum)type, 1), log ? log : "");
+			free(log);
+		}
+	}
+	GLC_STAT(compileTime += glc_seconds() - start);
+	if(success)
+	{
+#ifdef GLC_STATS
+		start = glc_seconds();
+#endif
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		GLC_STAT(linkTime += glc_seconds() - start);
+		if(!success)
+		{
+			log = glc_getInfoLog(program, GL_TRUE);
+			GLC_LOG(GLC_ERROR_LINK, "Shader program linking error!\n%s", log ? log : "");
+			free(log);
+		}
+	}
+	/* cleanup */
+	for(i = 0; i < info->pendingCount; i++)
+		glDeleteShader(info->pendingShaders[i]);
+	if(!success)
+	{
+		glcDeleteShaderProgram(program);
+		return -1;
+	}
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_get_program_binary)
+	glc_saveProgramBinary(program, info->binaryKey);
+#endif
+	/* a program the caller is told failed must not outlive the call */
+	if(glcCacheUniformLocations(program) == -1)
+	{
+		glcDeleteShaderProgram(program);
+		return -1;
+	}
+	GLC_STAT(programsBuilt++);
+	return 1;
+}
+
+/*	glcMakeShaderProgram()
+	Returns: 1 (success) or -1 (failure)
+	program - pointer to a to be shader program handle
+	vertexShaderPath - path to vertex shader source code file
+	fragmentShaderPath - path to fragment shader source code file */
+int glcMakeShaderProgram(GLuint* program, const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+	if(glcBeginShaderProgram(program, vertexShaderPath, fragmentShaderPath) == -1)
+		return -1;
+	return glcFinishShaderProgram(*program);
+}
+
+/*	glcMakeProgram()
+	Returns: 1 (success) or -1 (failure)
+	program - pointer to a to be shader program handle
+	stages - the shader stages to link, 1 to GLC_MAX_SHADER_STAGES of them
+	count - amount of stages */
+int glcMakeProgram(GLuint* program, const glcShaderStage* stages, int count)
+{
+	if(glcBeginProgram(program, stages, count) == -1)
+		return -1;
+	return glcFinishShaderProgram(*program);
+}
+
+#if defined(GL_VERSION_4_3) || defined(GL_ARB_compute_shader)
+
+/*	glcMakeComputeProgram()
+	Returns: 1 (success) or -1 (failure)
+	program - pointer to a to be shader program handle
+	computeShaderPath - path to compute shader source code file */
+int glcMakeComputeProgram(GLuint* program, const char* computeShaderPath)
+{
+	glcShaderStage stage;
+
+	memset(&stage, 0, sizeof(stage));
+	stage.type = GL_COMPUTE_SHADER;
+	stage.path = computeShaderPath;
+	return glcMakeProgram(program, &stage, 1);
+}
+
+/*	glcDispatchCompute()
+	Returns: 1 (success) or -1 (failure)
+	program - compute shader program handle
+	x, y, z - invocations wanted in each dimension, rounded up to whole
+		work groups of the program's local_size */
+int glcDispatchCompute(GLuint program, GLuint x, GLuint y, GLuint z)
+{
+	GLint* size;
+	glcProgramInfo* info = glc_getProgram(program);
+
+	if(!info)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Program %u is not linked.", program);
+		return -1;
+	}
+	size = info->workGroupSize;
+	if(!size[0])
+	{
+		glGetProgramiv(program, GL_COMPUTE_WORK_GROUP_SIZE, size);
+		if(size[0] < 1 || size[1] < 1 || size[2] < 1)
+		{
+			GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Program %u is not a compute program.", program);
+			size[0] = size[1] = size[2] = 0;
+			return -1;
+		}
+	}
+	glcUseProgram(program);
+	glDispatchCompute((x + size[0] - 1) / size[0], (y + size[1] - 1) / size[1], (z + size[2] - 1) / size[2]);
+	return 1;
+}
+
+#endif
+
+/*	glcMakeShaderProgramSource()
+	Returns: 1 (success) or -1 (failure)
+	program - pointer to a to be shader program handle
+	vertexSource - vertex shader source code
+	vertexLength - length of vertexSource, or -1 if null terminated
+	fragmentSource - fragment shader source code
+	fragmentLength - length of fragmentSource, or -1 if null terminated */
+int glcMakeShaderProgramSource(GLuint* program, const char* vertexSource, GLint vertexLength, const char* fragmentSource, GLint fragmentLength)
+{
+	if(glcBeginShaderProgramSource(program, vertexSource, vertexLength, fragmentSource, fragmentLength) == -1)
+		return -1;
+	return glcFinishShaderProgram(*program);
+}
+
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_separate_shader_objects)
+
+/*	Separable programs and pipelines
+	A separable program (GL_PROGRAM_SEPARABLE) holds one or a few stages and
+	is linked once; glcGetProgramPipeline() then assembles complete
+	pipelines from any combination of them without another link, so N vertex
+	and M fragment programs take N + M links rather than N x M. Pipelines are
+	cached by their set of programs and deleted along with any of them.
+	Pipeline objects are not shared between contexts, so each glcContext
+	keeps its own cache; deleting a program releases the pipelines of the
+	current context, other contexts' pipelines go with glcDeleteContext.
+	A bound program always wins over a bound pipeline, and the bound uniform
+	setters bind the handle's program. Either define GLC_DIRECT_STATE_ACCESS
+	or set uniforms before glcBindProgramPipeline(). */
+
+typedef struct glcPipeline
+{
+	unsigned long long key;		/* 0 marks a free slot */
+	GLuint pipeline;
+	int count;
+	GLuint programs[GLC_MAX_SHADER_STAGES];
+} glcPipeline;
+
+/* Order independent, the stages of a pipeline are distinct anyway. */
+static unsigned long long glc_pipelineKey(const GLuint* programs, int count)
+{
+	int i;
+	unsigned long long key = (unsigned long long)count;
+
+	for(i = 0; i < count; i++)
+	{
+		unsigned long long program = programs[i] * 0x9E3779B97F4A7C15ull;
+		key += program ^ (program >> 31);
+	}
+	return key ? key : 1;
+}
+
+static int glc_samePrograms(const glcPipeline* entry, const GLuint* programs, int count)
+{
+	int i, j;
+
+	if(entry->count != count)
+		return 0;
+	for(i = 0; i < count; i++)
+	{
+		for(j = 0; j < count && entry->programs[j] != programs[i]; j++);
+		if(j == count)
+			return 0;
+	}
+	return 1;
+}
+
+static int glc_growPipelines(glcContext* context)
+{
+	int i, capacity = context->pipelineCapacity ? context->pipelineCapacity * 2 : 32;
+	unsigned int j, mask = (unsigned int)capacity - 1;
+	glcPipeline* table = (glcPipeline*)calloc(capacity, sizeof(glcPipeline));
+
+	if(!table)
+		return -1;
+	for(i = 0; i < context->pipelineCapacity; i++)
+	{
+		if(!context->pipelines[i].key)
+			continue;
+		for(j = (unsigned int)context->pipelines[i].key & mask; table[j].key; j = (j + 1) & mask);
+		table[j] = context->pipelines[i];
+	}
+	free(context->pipelines);
+	context->pipelines = table;
+	context->pipelineCapacity = capacity;
+	return 1;
+}
+
+static void glc_releasePipelines(GLuint program)
+{
+	int i, j, removed = 0;
+	glcPipeline* pipeline;
+	glcContext* context = glc_getContext();
+
+	for(i = 0; i < context->pipelineCapacity; i++)
+	{
+		pipeline = &context->pipelines[i];
+		for(j = 0; pipeline->key && j < pipeline->count && pipeline->programs[j] != program; j++);
+		if(!pipeline->key || j == pipeline->count)
+			continue;
+		if(pipeline->pipeline == context->currentPipeline)
+			context->currentPipeline = GLC_UNKNOWN_PROGRAM;
+		glDeleteProgramPipelines(1, &pipeline->pipeline);
+		pipeline->key = 0;
+		context->pipelineCount--;
+		removed = 1;
+	}
+	/* reinsert the survivors so no probe chain is left with a hole */
+	if(removed)
+	{
+		glcPipeline* old = context->pipelines;
+		int capacity = context->pipelineCapacity;
+		unsigned int mask = (unsigned int)capacity - 1, k;
+		if(!(context->pipelines = (glcPipeline*)calloc(capacity, sizeof(glcPipeline))))
+		{
+			/* keep the old table; lookups then just rebuild missing entries */
+			context->pipelines = old;
+			return;
+		}
+		for(i = 0; i < capacity; i++)
+		{
+			if(!old[i].key)
+				continue;
+			for(k = (unsigned int)old[i].key & mask; context->pipelines[k].key; k = (k + 1) & mask);
+			context->pipelines[k] = old[i];
+		}
+		free(old);
+	}
+}
+
+/*	glcBeginSeparableProgram()
+	Returns: 1 (success) or -1 (failure)
+	program - pointer to a to be separable shader program handle
+	stages - the shader stages to link into it, usually just one
+	count - amount of stages
+	Finish it with glcFinishShaderProgram, like glcBeginProgram. */
+int glcBeginSeparableProgram(GLuint* program, const glcShaderStage* stages, int count)
+{
+	return glc_beginProgram(program, stages, count, GL_TRUE);
+}
+
+/*	glcMakeSeparableProgram()
+	Returns: 1 (success) or -1 (failure)
+	program - pointer to a to be separable shader program handle
+	stages - the shader stages to link into it, usually just one
+	count - amount of stages */
+int glcMakeSeparableProgram(GLuint* program, const glcShaderStage* stages, int count)
+{
+	if(glc_beginProgram(program, stages, count, GL_TRUE) == -1)
+		return -1;
+	return glcFinishShaderProgram(*program);
+}
+
+/*	glcGetProgramPipeline()
+	Returns: 1 (success) or -1 (failure)
+	pipeline - receives the program pipeline handle, owned by glc
+	programs - separable programs whose stages make up the pipeline
+	count - amount of programs, 1 to GLC_MAX_SHADER_STAGES
+	The first call for a set of programs creates the pipeline, later calls
+	return it from the cache in any program order. */
+int glcGetProgramPipeline(GLuint* pipeline, const GLuint* programs, int count)
+{
+	int i;
+	unsigned int j, mask;
+	GLbitfield used = 0;
+	glcProgramInfo* info;
+	glcPipeline* entry;
+	unsigned long long key;
+	glcContext* context = glc_getContext();
+
+	if(count < 1 || count > GLC_MAX_SHADER_STAGES)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Program count invalid. Must be 1-%d. Got %d.", GLC_MAX_SHADER_STAGES, count);
+		return -1;
+	}
+	key = glc_pipelineKey(programs, count);
+	if(context->pipelineCapacity)
+	{
+		mask = (unsigned int)context->pipelineCapacity - 1;
+		for(j = (unsigned int)key & mask; context->pipelines[j].key; j = (j + 1) & mask)
+		{
+			if(context->pipelines[j].key == key && glc_samePrograms(&context->pipelines[j], programs, count))
+			{
+				*pipeline = context->pipelines[j].pipeline;
+				return 1;
+			}
+		}
+	}
+	/* also finishes programs that are still building */
+	for(i = 0; i < count; i++)
+	{
+		if(!(info = glc_getProgram(programs[i])) || !info->separableStages)
+		{
+			GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Program %u is not a linked separable program.", programs[i]);
+			return -1;
+		}
+		if(used & info->separableStages)
+		{
+			GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Program %u repeats a pipeline stage.", programs[i]);
+			return -1;
+		}
+		used |= info->separableStages;
+	}
+	if((context->pipelineCount + 1) * 2 > context->pipelineCapacity && glc_growPipelines(context) == -1)
+	{
+		GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when creating program pipeline.");
+		return -1;
+	}
+	glGenProgramPipelines(1, pipeline);
+	if(!(*pipeline))
+	{
+		GLC_LOG(GLC_ERROR_GL_OBJECT, "Error creating program pipeline object.");
+		return -1;
+	}
+	for(i = 0; i < count; i++)
+		glUseProgramStages(*pipeline, glc_findProgram(programs[i])->separableStages, programs[i]);
+	mask = (unsigned int)context->pipelineCapacity - 1;
+	for(j = (unsigned int)key & mask; context->pipelines[j].key; j = (j + 1) & mask);
+	entry = &context->pipelines[j];
+	entry->key = key;
+	entry->pipeline = *pipeline;
+	entry->count = count;
+	memcpy(entry->programs, programs, count * sizeof(GLuint));
+	context->pipelineCount++;
+	return 1;
+}
+
+/*	glcBindProgramPipeline()
+	pipeline - program pipeline handle from glcGetProgramPipeline
+	Unbinds any program, which would override the pipeline, and binds the
+	pipeline unless it is already current. */
+void glcBindProgramPipeline(GLuint pipeline)
+{
+	glcContext* context = glc_getContext();
+
+	glcUseProgram(0);
+	if(pipeline == context->currentPipeline)
+		return;
+	glBindProgramPipeline(pipeline);
+	context->currentPipeline = pipeline;
+}
+
+#endif
+
+/*	Shader preprocessor and variants
+	glcPreprocessShader() expands #include "file" directives, resolved next
+	to the including file and honouring #pragma once, and injects a set of
+	defines right after the #version line. #line directives keep compiler
+	messages pointing at the right file: source string 0 is the shader
+	itself, includes are numbered in the order they are first entered.
+	glcMakeProgramVariant() builds a program from preprocessed stages and
+	remembers it under a permutation key hashed from the stages and the
+	define set (in any order), so each variant compiles once per process.
+	The expanded sources also key the program binary cache, so variants are
+	reused across runs too. */
+#define GLC_MAX_INCLUDE_DEPTH 32
+
+typedef struct glcText
+{
+	char* data;
+	size_t length;
+	size_t capacity;
+} glcText;
+
+typedef struct glcPreprocessor
+{
+	glcText out;
+	glcText once;		/* null separated paths of files that had #pragma once */
+	int sources;		/* source string numbers handed out so far */
+	const char* const* defines;
+	int defineCount;
+} glcPreprocessor;
+
+static int glc_appendText(glcText* text, const char* data, size_t length)
+{
+	if(text->length + length + 1 > text->capacity)
+	{
+		size_t capacity = text->capacity ? text->capacity : 1024;
+		char* grown;
+		while(capacity < text->length + length + 1)
+			capacity *= 2;
+		if(!(grown = (char*)realloc(text->data, capacity)))
+			return -1;
+		text->data = grown;
+		text->capacity = capacity;
+	}
+	memcpy(text->data + text->length, data, length);
+	text->length += length;
+	text->data[text->length] = '\0';
+	return 1;
+}
+
+static int glc_appendLine(glcText* text, int line, int source)
+{
+	char directive[32];
+	sprintf(directive, "#line %d %d\n", line, source);
+	return glc_appendText(text, directive, strlen(directive));
+}
+
+static int glc_appendDefines(glcPreprocessor* pp)
+{
+	int i;
+
+	for(i = 0; i < pp->defineCount; i++)
+	{
+		/* "NAME", "NAME VALUE" and "NAME=VALUE" are all accepted */
+		const char* define = pp->defines[i];
+		const char* equals = strchr(define, '=');
+		size_t name = equals ? (size_t)(equals - define) : strlen(define);
+		if(glc_appendText(&pp->out, "#define ", 8) == -1 ||
+			glc_appendText(&pp->out, define, name) == -1 ||
+			(equals && (glc_appendText(&pp->out, " ", 1) == -1 ||
+				glc_appendText(&pp->out, equals + 1, strlen(equals + 1)) == -1)) ||
+			glc_appendText(&pp->out, "\n", 1) == -1)
+			return -1;
+	}
+	return 1;
+}
+
+static int glc_isOnce(const glcPreprocessor* pp, const char* path)
+{
+	size_t i;
+
+	for(i = 0; i < pp->once.length; i += strlen(pp->once.data + i) + 1)
+	{
+		if(!strcmp(pp->once.data + i, path))
+			return 1;
+	}
+	return 0;
+}
+
+/* Matches a preprocessor directive at the start of a line, returning the
+   text after it or NULL. */
+static const char* glc_directive(const char* line, const char* end, const char* name)
+{
+	size_t length = strlen(name);
+
+	while(line < end && (*line == ' ' || *line == '\t'))
+		line++;
+	if(line == end || *line++ != '#')
+		return NULL;
+	while(line < end && (*line == ' ' || *line == '\t'))
+		line++;
+	if((size_t)(end - line) < length || strncmp(line, name, length))
+		return NULL;
+	line += length;
+	if(line < end && *line != ' ' && *line != '\t' && *line != '\r' && *line != '"' && *line != '<')
+		return NULL;
+	return line;
+}
+
+/* Finds the #version directive behind any leading blank lines and comments,
+   returning where it starts or NULL. */
+static const char* glc_findVersion(const char* c, const char* end)
+{
+	while(c < end)
+	{
+		if(*c == ' ' || *c == '\t' || *c == '\r' || *c == '\n')
+			c++;
+		else if(end - c >= 2 && c[0] == '/' && c[1] == '/')
+		{
+			while(c < end && *c != '\n')
+				c++;
+		}
+		else if(end - c >= 2 && c[0] == '/' && c[1] == '*')
+		{
+			for(c += 2; end - c >= 2 && (c[0] != '*' || c[1] != '/'); c++);
+			if(end - c < 2)
+				return NULL;
+			c += 2;
+		}
+		else
+			return glc_directive(c, end, "version") ? c : NULL;
+	}
+	return NULL;
+}
+
+static int glc_isPragmaOnce(const char* argument, const char* end)
+{
+	while(argument < end && (*argument == ' ' || *argument == '\t'))
+		argument++;
+	return end - argument >= 4 && !strncmp(argument, "once", 4);
+}
+
+static int glc_preprocessText(glcPreprocessor* pp, const char* source, size_t length, const char* path, int depth)
+{
+	int lineNumber = 1, number = pp->sources++, comment = 0, versioned = 0;
+	const char* line = source, *end = source + length, *version = NULL;
+
+	if(depth > GLC_MAX_INCLUDE_DEPTH)
+	{
+		GLC_LOG(GLC_ERROR_COMPILE, "Shader include depth exceeded in: %s", path ? path : "<source>");
+		return -1;
+	}
+	/* defines go after #version, or first if there is none */
+	if(depth)
+	{
+		if(glc_appendLine(&pp->out, 1, number) == -1)
+			return -1;
+	}
+	else if(!(version = glc_findVersion(source, end)))
+	{
+		versioned = 1;
+		if(glc_appendDefines(pp) == -1 || glc_appendLine(&pp->out, 1, number) == -1)
+			return -1;
+	}
+	while(line < end)
+	{
+		const char* next = (const char*)memchr(line, '\n', end - line);
+		const char* argument, *c;
+		next = next ? next + 1 : end;
+
+		if(!comment && (argument = glc_directive(line, next, "include")))
+		{
+			char* includePath, *included;
+			const char* open, *close;
+			GLint includedLength;
+			size_t directory = 0;
+			int result;
+
+			open = argument;
+			while(open < next && *open != '"' && *open != '<')
+				open++;
+			close = (open < next) ? (const char*)memchr(open + 1, *open == '"' ? '"' : '>', next - open - 1) : NULL;
+			if(!close)
+			{
+				GLC_LOG(GLC_ERROR_COMPILE, "Malformed #include in %s line %d", path ? path : "<source>", lineNumber);
+				return -1;
+			}
+			if(path)
+			{
+				const char* slash = strrchr(path, '/');
+				const char* backslash = strrchr(path, '\\');
+				if(backslash > slash)
+					slash = backslash;
+				directory = slash ? (size_t)(slash - path) + 1 : 0;
+			}
+			if(!(includePath = (char*)malloc(directory + (close - open))))
+				return -1;
+			if(directory)
+				memcpy(includePath, path, directory);
+			memcpy(includePath + directory, open + 1, close - open - 1);
+			includePath[directory + (close - open) - 1] = '\0';
+			result = 1;
+			if(!glc_isOnce(pp, includePath) &&
+				(result = glcLoadShaderSource(includePath, &included, &includedLength)) == 1)
+			{
+				result = glc_preprocessText(pp, included, (size_t)includedLength, includePath, depth + 1);
+				free(included);
+				/* a file without a trailing newline would swallow the #line */
+				if(result == 1 && pp->out.length && pp->out.data[pp->out.length - 1] != '\n')
+					result = glc_appendText(&pp->out, "\n", 1);
+			}
+			if(result == 1)
+				result = glc_appendLine(&pp->out, lineNumber + 1, number);
+			free(includePath);
+			if(result == -1)
+				return -1;
+		}
+		else if(!comment && path && (argument = glc_directive(line, next, "pragma")) && glc_isPragmaOnce(argument, next))
+		{
+			/* blanked rather than dropped to keep the line numbers */
+			if((!glc_isOnce(pp, path) && glc_appendText(&pp->once, path, strlen(path) + 1) == -1) ||
+				glc_appendText(&pp->out, "\n", 1) == -1)
+				return -1;
+		}
+		else
+		{
+			if(glc_appendText(&pp->out, line, next - line) == -1)
+				return -1;
+			if(!depth && !versioned && version < next)
+			{
+				versioned = 1;
+				if((next == end && glc_appendText(&pp->out, "\n", 1) == -1) ||
+					glc_appendDefines(pp) == -1 || glc_appendLine(&pp->out, lineNumber + 1, number) == -1)
+					return -1;
+			}
+		}
+		/* track block comments so commented out directives stay inert */
+		for(c = line; c + 1 < next; c++)
+		{
+			if(!comment && c[0] == '/' && c[1] == '/')
+				break;
+			if(!comment && c[0] == '/' && c[1] == '*')
+				comment = 1, c++;
+			else if(comment && c[0] == '*' && c[1] == '/')
+				comment = 0, c++;
+		}
+		line = next;
+		lineNumber++;
+	}
+	return 1;
+}
+
+/*	glcPreprocessShader()
+	Returns: 1 (success) or -1 (failure)
+	stage - shader source file or in-memory source to expand. Includes of
+		an in-memory source resolve against the working directory.
+	defines - defines to inject, as "NAME", "NAME VALUE" or "NAME=VALUE"
+	defineCount - amount of defines
+	output - receives the expanded, null terminated source, release with free()
+	length - receives the length of the expanded source */
+int glcPreprocessShader(const glcShaderStage* stage, const char* const* defines, int defineCount, char** output, GLint* length)
+{
+	int result;
+	char* loaded = NULL;
+	const char* source = stage->source;
+	GLint sourceLength = stage->length;
+	glcPreprocessor pp;
+
+	*output = NULL;
+	*length = 0;
+	if(stage->path)
+	{
+		if(glcLoadShaderSource(stage->path, &loaded, &sourceLength) == -1)
+			return -1;
+		source = loaded;
+	}
+	else if(sourceLength < 0)
+		sourceLength = (GLint)strlen(source);
+	if(glc_isSpirv(source, sourceLength))
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "SPIR-V %s shader can not be preprocessed.", glc_stageName(stage->type, 0));
+		free(loaded);
+		return -1;
+	}
+	memset(&pp, 0, sizeof(pp));
+	pp.defines = defines;
+	pp.defineCount = defineCount;
+	result = glc_preprocessText(&pp, source, (size_t)sourceLength, stage->path, 0);
+	if(result == 1 && !pp.out.data)
+		result = glc_appendText(&pp.out, "", 0);
+	free(loaded);
+	free(pp.once.data);
+	if(result == -1)
+	{
+		GLC_LOG(GLC_ERROR_COMPILE, "Error preprocessing %s shader.", glc_stageName(stage->type, 0));
+		free(pp.out.data);
+		return -1;
+	}
+	*output = pp.out.data;
+	*length = (GLint)pp.out.length;
+	return 1;
+}
+
+typedef struct glcVariant
+{
+	unsigned long long key;
+	GLuint program;
+} glcVariant;
+
+static glcVariant* glc_variants = NULL;
+static int glc_variantCount = 0;
+static int glc_variantCapacity = 0;	/* power of two */
+
+static unsigned long long glc_variantKey(const glcShaderStage* stages, int count, const char* const* defines, int defineCount)
+{
+	int i;
+	unsigned long long set = 0, hash = 14695981039346656037ull;
+
+	for(i = 0; i < count; i++)
+	{
+		hash = glc_hashBytes(hash, &stages[i].type, sizeof(GLenum));
+		if(stages[i].path)
+			hash = glc_hashBytes(hash, stages[i].path, strlen(stages[i].path) + 1);
+		else
+			hash = glc_hashBytes(hash, stages[i].source,
+				stages[i].length < 0 ? strlen(stages[i].source) : (size_t)stages[i].length);
+	}
+	/* the define set is order independent */
+	for(i = 0; i < defineCount; i++)
+	{
+		unsigned long long define = glc_hashBytes(14695981039346656037ull, defines[i], strlen(defines[i]));
+		set += define ^ (define >> 29);
+	}
+	hash = glc_hashBytes(hash, &set, sizeof(set));
+	return hash ? hash : 1;
+}
+
+static glcVariant* glc_findVariant(unsigned long long key)
+{
+	unsigned int i, mask;
+
+	if(!glc_variantCapacity)
+		return NULL;
+	mask = (unsigned int)glc_variantCapacity - 1;
+	for(i = (unsigned int)key & mask; glc_variants[i].key; i = (i + 1) & mask)
+	{
+		if(glc_variants[i].key == key)
+			return &glc_variants[i];
+	}
+	return NULL;
+}
+
+static int glc_insertVariant(unsigned long long key, GLuint program)
+{
+	unsigned int i, mask;
+	glcVariant* variant = glc_findVariant(key);
+
+	if(variant)
+	{
+		variant->program = program;
+		return 1;
+	}
+	if((glc_variantCount + 1) * 2 > glc_variantCapacity)
+	{
+		int j, capacity = glc_variantCapacity ? glc_variantCapacity * 2 : 64;
+		glcVariant* table = (glcVariant*)calloc(capacity, sizeof(glcVariant));
+		if(!table)
+			return -1;
+		mask = (unsigned int)capacity - 1;
+		for(j = 0; j < glc_variantCapacity; j++)
+		{
+			if(!glc_variants[j].key)
+				continue;
+			for(i = (unsigned int)glc_variants[j].key & mask; table[i].key; i = (i + 1) & mask);
+			table[i] = glc_variants[j];
+		}
+		free(glc_variants);
+		glc_variants = table;
+		glc_variantCapacity = capacity;
+	}
+	mask = (unsigned int)glc_variantCapacity - 1;
+	for(i = (unsigned int)key & mask; glc_variants[i].key; i = (i + 1) & mask);
+	glc_variants[i].key = key;
+	glc_variants[i].program = program;
+	glc_variantCount++;
+	return 1;
+}
+
+/*	glcMakeProgramVariant()
+	Returns: 1 (success) or -1 (failure)
+	program - pointer to a to be shader program handle
+	stages - the shader stages to link, 1 to GLC_MAX_SHADER_STAGES of them
+	count - amount of stages
+	defines - defines for this variant, as "NAME", "NAME VALUE" or "NAME=VALUE"
+	defineCount - amount of defines
+	Returns the same program for the same stages and define set for as long
+	as it is not deleted. File stages are keyed by path, so an edited file
+	needs a fresh glcMakeProgram to be picked up. */
+int glcMakeProgramVariant(GLuint* program, const glcShaderStage* stages, int count, const char* const* defines, int defineCount)
+{
+	int i, result = -1;
+	char* expanded[GLC_MAX_SHADER_STAGES] = {NULL};
+	glcShaderStage variant[GLC_MAX_SHADER_STAGES];
+	glcProgramInfo* info;
+	glcVariant* cached;
+	GLuint found;
+	unsigned long long key;
+
+	if(count < 1 || count > GLC_MAX_SHADER_STAGES)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Stage count invalid. Must be 1-%d. Got %d.", GLC_MAX_SHADER_STAGES, count);
+		return -1;
+	}
+	key = glc_variantKey(stages, count, defines, defineCount);
+	GLC_LOCK(&glc_shareLock);
+	found = (cached = glc_findVariant(key)) ? cached->program : 0;
+	GLC_UNLOCK(&glc_shareLock);
+	/* the program must still be alive and be the one built for this key */
+	if(found && (info = glc_findProgram(found)) && info->variantKey == key)
+	{
+		*program = found;
+		return 1;
+	}
+	for(i = 0; i < count; i++)
+	{
+		variant[i].type = stages[i].type;
+		variant[i].path = NULL;
+		if(glcPreprocessShader(&stages[i], defines, defineCount, &expanded[i], &variant[i].length) == -1)
+			goto cleanup;
+		variant[i].source = expanded[i];
+	}
+	if(glcMakeProgram(program, variant, count) == -1 || !(info = glc_findProgram(*program)))
+		goto cleanup;
+	info->variantKey = key;
+	/* built outside the lock, two threads making one variant just both build it */
+	GLC_LOCK(&glc_shareLock);
+	i = glc_insertVariant(key, *program);
+	GLC_UNLOCK(&glc_shareLock);
+	if(i == -1)
+		GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when caching shader variant.");
+	result = 1;
+
+cleanup:
+	for(i = 0; i < count; i++)
+		free(expanded[i]);
+	return result;
+}
+
+/*	Shader hot reload
+	glcWatchProgram() remembers how a program was built and the variable
+	holding its handle. glcReloadShaders(), called once per frame, notices
+	edited stage files and rebuilds them with glcBeginProgram. The old program
+	keeps rendering until the new one has finished building and linked
+	successfully; only then is the handle swapped and the old program
+	deleted. A failed build keeps the old program and prints the log.
+	Changes are picked up through inotify on Linux, directory change
+	notifications on Windows and file time stamps elsewhere. With parallel
+	shader compile the frame never waits on the compiler; without it the
+	build happens inside the glcReloadShaders call that sees the edit.
+	Only the stage files themselves are watched, not files they #include.
+	A swapped program starts with default uniform values and a new name, so
+	uniform handles and pipelines made from the old one must be made again;
+	the return value of glcReloadShaders tells when. */
+
+typedef struct glcWatchDirectory
+{
+	char* path;
+#if defined(__linux__)
+	int descriptor;
+#elif defined(_WIN32)
+	HANDLE change;
+#endif
+} glcWatchDirectory;
+
+typedef struct glcWatch
+{
+	GLuint* program;		/* application variable holding the live handle */
+	GLuint building;		/* replacement being built, 0 if none */
+	GLboolean dirty;		/* a stage file changed since the last build started */
+	GLboolean separable;
+	int count;
+	glcShaderStage stages[GLC_MAX_SHADER_STAGES];	/* with glc owned strings */
+	int directories[GLC_MAX_SHADER_STAGES];	/* index in glc_watchDirectories, -1 for source stages */
+	unsigned long long stamps[GLC_MAX_SHADER_STAGES];
+} glcWatch;
+
+static glcWatch* glc_watches = NULL;
+static int glc_watchCount = 0;
+static int glc_watchCapacity = 0;
+static glcWatchDirectory* glc_watchDirectories = NULL;
+static int glc_watchDirectoryCount = 0;
+#if defined(__linux__)
+static int glc_inotify = -1;
+#endif
+
+/* Modification time and size folded together, 0 if the file is missing. */
+static unsigned long long glc_fileStamp(const char* path)
+{
+#if defined(_WIN32)
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if(!GetFileAttributesExA(path, GetFileExInfoStandard, &data))
+		return 0;
+	return (((unsigned long long)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime) ^
+		((unsigned long long)data.nFileSizeLow << 40);
+#elif defined(__unix__) || defined(__APPLE__)
+	struct stat info;
+	if(stat(path, &info))
+		return 0;
+	return ((unsigned long long)info.st_mtime << 20) ^ (unsigned long long)info.st_size;
+#else
+	FILE* file = fopen(path, "rb");
+	long size;
+	if(!file)
+		return 0;
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fclose(file);
+	return (unsigned long long)size + 1;
+#endif
+}
+
+static const char* glc_fileName(const char* path)
+{
+	const char* slash = strrchr(path, '/');
+#if defined(_WIN32)
+	const char* backslash = strrchr(path, '\\');
+	if(backslash > slash)
+		slash = backslash;
+#endif
+	return slash ? slash + 1 : path;
+}
+
+static char* glc_copyString(const char* string, GLint length)
+{
+	size_t size = (length < 0) ? strlen(string) : (size_t)length;
+	char* copy = (char*)malloc(size + 1);
+
+	if(copy)
+	{
+		memcpy(copy, string, size);
+		copy[size] = '\0';
+	}
+	return copy;
+}
+
+/* Returns the index of the watched directory holding path, adding it if new. */
+static int glc_watchDirectory(const char* path)
+{
+	int i;
+	size_t length = (size_t)(glc_fileName(path) - path);
+	char* directory;
+	glcWatchDirectory* grown;
+
+	if(!(directory = glc_copyString(length ? path : ".", length ? (GLint)length : -1)))
+		return -1;
+	for(i = 0; i < glc_watchDirectoryCount; i++)
+	{
+		if(!strcmp(glc_watchDirectories[i].path, directory))
+		{
+			free(directory);
+			return i;
+		}
+	}
+	if(!(grown = (glcWatchDirectory*)realloc(glc_watchDirectories, (glc_watchDirectoryCount + 1) * sizeof(glcWatchDirectory))))
+	{
+		free(directory);
+		return -1;
+	}
+	glc_watchDirectories = grown;
+	grown[i].path = directory;
+	/* without a notification handle the directory is simply polled */
+#if defined(__linux__)
+	if(glc_inotify == -1)
+		glc_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	grown[i].descriptor = (glc_inotify == -1) ? -1 :
+		inotify_add_watch(glc_inotify, directory, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+#elif defined(_WIN32)
+	grown[i].change = FindFirstChangeNotificationA(directory, FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+#endif
+	glc_watchDirectoryCount++;
+	return i;
+}
+
+static void glc_freeWatch(glcWatch* watch)
+{
+	int i;
+
+	if(watch->building)
+		glcDeleteShaderProgram(watch->building);
+	for(i = 0; i < watch->count; i++)
+	{
+		free((char*)watch->stages[i].path);
+		free((char*)watch->stages[i].source);
+	}
+}
+
+/*	glcUnwatchProgram()
+	program - the same handle variable given to glcWatchProgram
+	Stops watching. The program itself is left alone. */
+void glcUnwatchProgram(GLuint* program)
+{
+	int i;
+
+	for(i = 0; i < glc_watchCount; i++)
+	{
+		if(glc_watches[i].program == program)
+		{
+			glc_freeWatch(&glc_watches[i]);
+			glc_watches[i] = glc_watches[--glc_watchCount];
+			return;
+		}
+	}
+}
+
+/*	glcWatchProgram()
+	Returns: 1 (success) or -1 (failure)
+	program - variable holding the handle of a program built from stages.
+		glcReloadShaders writes the new handle here, so it must stay valid
+		until glcUnwatchProgram.
+	stages - the stages the program was built from, copied
+	count - amount of stages */
+int glcWatchProgram(GLuint* program, const glcShaderStage* stages, int count)
+{
+	int i;
+	glcWatch watch;
+	glcProgramInfo* info;
+
+	if(count < 1 || count > GLC_MAX_SHADER_STAGES)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Stage count invalid. Must be 1-%d. Got %d.", GLC_MAX_SHADER_STAGES, count);
+		return -1;
+	}
+	glcUnwatchProgram(program);
+	if(glc_watchCount == glc_watchCapacity)
+	{
+		int capacity = glc_watchCapacity ? glc_watchCapacity * 2 : 16;
+		glcWatch* grown = (glcWatch*)realloc(glc_watches, capacity * sizeof(glcWatch));
+		if(!grown)
+		{
+			GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when watching shader program.");
+			return -1;
+		}
+		glc_watches = grown;
+		glc_watchCapacity = capacity;
+	}
+	memset(&watch, 0, sizeof(watch));
+	watch.program = program;
+	info = glc_findProgram(*program);
+	watch.separable = (info && info->separableStages) ? GL_TRUE : GL_FALSE;
+	for(i = 0; i < count; i++, watch.count++)
+	{
+		watch.stages[i].type = stages[i].type;
+		watch.stages[i].length = -1;
+		watch.directories[i] = -1;
+		if(stages[i].path)
+		{
+			watch.stages[i].path = glc_copyString(stages[i].path, -1);
+			watch.directories[i] = glc_watchDirectory(stages[i].path);
+			watch.stamps[i] = glc_fileStamp(stages[i].path);
+			if(!watch.stages[i].path || watch.directories[i] == -1)
+				break;
+		}
+		else if(!(watch.stages[i].source = glc_copyString(stages[i].source, stages[i].length)))
+			break;
+	}
+	if(i < count)
+	{
+		watch.count = i + 1;
+		glc_freeWatch(&watch);
+		GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when watching shader program.");
+		return -1;
+	}
+	glc_watches[glc_watchCount++] = watch;
+	return 1;
+}
+
+/* Marks the watches using the changed file, or every file in the directory
+   when name is NULL, whose time stamp moved. */
+static void glc_markChanged(int directory, const char* name)
+{
+	int i, j;
+	unsigned long long stamp;
+	glcWatch* watch;
+
+	for(i = 0; i < glc_watchCount; i++)
+	{
+		watch = &glc_watches[i];
+		for(j = 0; j < watch->count; j++)
+		{
+			if(watch->directories[j] != directory ||
+				(name && strcmp(glc_fileName(watch->stages[j].path), name)))
+				continue;
+			stamp = glc_fileStamp(watch->stages[j].path);
+			/* a name match is trusted, a save can keep time and size the same */
+			if(stamp && (name || stamp != watch->stamps[j]))
+			{
+				watch->stamps[j] = stamp;
+				watch->dirty = GL_TRUE;
+			}
+		}
+	}
+}
+
+static void glc_pollWatchDirectories(void)
+{
+	int i;
+#if defined(__linux__)
+	union
+	{
+		int align;		/* inotify_event only holds ints */
+		char bytes[4096];
+	} buffer;
+	ssize_t length, offset;
+	const struct inotify_event* event;
+	int j;
+
+	if(glc_inotify != -1)
+	{
+		while((length = read(glc_inotify, buffer.bytes, sizeof(buffer))) > 0)
+		{
+			for(offset = 0; offset < length; offset += sizeof(struct inotify_event) + event->len)
+			{
+				event = (const struct inotify_event*)(buffer.bytes + offset);
+				for(j = 0; j < glc_watchDirectoryCount && glc_watchDirectories[j].descriptor != event->wd; j++);
+				if(j < glc_watchDirectoryCount && event->len)
+					glc_markChanged(j, event->name);
+			}
+		}
+	}
+	for(i = 0; i < glc_watchDirectoryCount; i++)
+	{
+		if(glc_watchDirectories[i].descriptor == -1)
+			glc_markChanged(i, NULL);
+	}
+#elif defined(_WIN32)
+	for(i = 0; i < glc_watchDirectoryCount; i++)
+	{
+		HANDLE change = glc_watchDirectories[i].change;
+		if(change == INVALID_HANDLE_VALUE)
+			glc_markChanged(i, NULL);
+		else if(WaitForSingleObject(change, 0) == WAIT_OBJECT_0)
+		{
+			glc_markChanged(i, NULL);
+			FindNextChangeNotification(change);
+		}
+	}
+#else
+	for(i = 0; i < glc_watchDirectoryCount; i++)
+		glc_markChanged(i, NULL);
+#endif
+}
+
+/*	glcReloadShaders()
+	Returns: amount of watched programs whose handle was swapped
+	Call once per frame. Starts rebuilds for edited programs and swaps in
+	those whose rebuild finished and linked. */
+int glcReloadShaders(void)
+{
+	int i, swapped = 0;
+	glcWatch* watch;
+
+	if(!glc_watchCount)
+		return 0;
+	glc_pollWatchDirectories();
+	for(i = 0; i < glc_watchCount; i++)
+	{
+		watch = &glc_watches[i];
+		if(watch->building && glcShaderProgramReady(watch->building))
+		{
+			/* a failed build is deleted by glcFinishShaderProgram */
+			if(glcFinishShaderProgram(watch->building) == 1)
+			{
+				glcDeleteShaderProgram(*watch->program);
+				*watch->program = watch->building;
+				swapped++;
+			}
+			watch->building = 0;
+		}
+		/* an edit during a build waits for it, then builds again */
+		if(watch->dirty && !watch->building)
+		{
+			watch->dirty = GL_FALSE;
+			if(glc_beginProgram(&watch->building, watch->stages, watch->count, watch->separable) == -1)
+				watch->building = 0;
+		}
+	}
+	return swapped;
+}
+
+/*	Shader packs
+	A shader pack is a single file holding many named shader sources, meant
+	to be shipped instead of loose files. glcOpenShaderPack() maps it into
+	memory and glcFindShaderSource() returns pointers straight into the
+	mapping, so sources feed glcMakeShaderProgramSource with no copies.
+	Layout, all fields 32 bit in native byte order:
+		"GLCP", version, entry count
+		entries sorted by name: name offset, name length, source offset, source length
+		names and sources, each followed by a null terminator */
+#define GLC_PACK_MAGIC 0x50434c47u	/* "GLCP" */
+#define GLC_PACK_VERSION 1u
+
+typedef struct glcShaderPack
+{
+	const unsigned char* data;
+	size_t size;
+	unsigned int count;
+#if defined(_WIN32)
+	HANDLE file, mapping;
+#endif
+} glcShaderPack;
+
+static const unsigned int* glc_packEntry(const glcShaderPack* pack, unsigned int i)
+{
+	return (const unsigned int*)pack->data + 3 + i * 4;
+}
+
+/*	glcCloseShaderPack()
+	pack - shader pack opened by glcOpenShaderPack */
+void glcCloseShaderPack(glcShaderPack* pack)
+{
+	if(!pack->data)
+		return;
+#if defined(_WIN32)
+	UnmapViewOfFile(pack->data);
+	CloseHandle(pack->mapping);
+	CloseHandle(pack->file);
+#elif defined(GLC_HAS_MMAP)
+	munmap((void*)pack->data, pack->size);
+#else
+	free((void*)pack->data);
+#endif
+	pack->data = NULL;
+	pack->size = 0;
+	pack->count = 0;
+}
+
+/*	glcOpenShaderPack()
+	Returns: 1 (success) or -1 (failure)
+	pack - pointer to a to be shader pack
+	path - path to the pack file */
+int glcOpenShaderPack(glcShaderPack* pack, const char* path)
+{
+	unsigned int i;
+	const unsigned int* header;
+
+	memset(pack, 0, sizeof(glcShaderPack));
+#if defined(_WIN32)
+	{
+		LARGE_INTEGER size;
+		pack->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(pack->file == INVALID_HANDLE_VALUE)
+		{
+			GLC_LOG(GLC_ERROR_FILE, "Error opening shader pack: %s", path);
+			return -1;
+		}
+		if(GetFileSizeEx(pack->file, &size) && size.QuadPart &&
+			(pack->mapping = CreateFileMappingA(pack->file, NULL, PAGE_READONLY, 0, 0, NULL)))
+			pack->data = (const unsigned char*)MapViewOfFile(pack->mapping, FILE_MAP_READ, 0, 0, 0);
+		pack->size = (size_t)size.QuadPart;
+		if(!pack->data)
+		{
+			if(pack->mapping)
+				CloseHandle(pack->mapping);
+			CloseHandle(pack->file);
+		}
+	}
+#elif defined(GLC_HAS_MMAP)
+	{
+		struct stat info;
+		int file = open(path, O_RDONLY);
+		if(file == -1)
+		{
+			GLC_LOG(GLC_ERROR_FILE, "Error opening shader pack: %s", path);
+			return -1;
+		}
+		if(fstat(file, &info) == 0 && info.st_size > 0)
+		{
+			void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+			if(data != MAP_FAILED)
+			{
+				pack->data = (const unsigned char*)data;
+				pack->size = (size_t)info.st_size;
+			}
+		}
+		close(file);
+	}
+#else
+	{
+		char* data;
+		GLint length;
+		if(glcLoadShaderSource(path, &data, &length) == -1)
+			return -1;
+		pack->data = (const unsigned char*)data;
+		pack->size = (size_t)length;
+	}
+#endif
+	if(!pack->data)
+	{
+		GLC_LOG(GLC_ERROR_FILE, "Error mapping shader pack: %s", path);
+		memset(pack, 0, sizeof(glcShaderPack));
+		return -1;
+	}
+	/* validate everything once so lookups can trust the index */
+	header = (const unsigned int*)pack->data;
+	if(pack->size < 12 || header[0] != GLC_PACK_MAGIC || header[1] != GLC_PACK_VERSION ||
+		header[2] > (pack->size - 12) / 16)
+	{
+		GLC_LOG(GLC_ERROR_FILE, "Shader pack invalid: %s", path);
+		glcCloseShaderPack(pack);
+		return -1;
+	}
+	pack->count = header[2];
+	for(i = 0; i < pack->count; i++)
+	{
+		const unsigned int* entry = glc_packEntry(pack, i);
+		if(entry[0] >= pack->size || entry[1] >= pack->size - entry[0] || pack->data[entry[0] + entry[1]] ||
+			entry[2] >= pack->size || entry[3] >= pack->size - entry[2] || pack->data[entry[2] + entry[3]])
+		{
+			GLC_LOG(GLC_ERROR_FILE, "Shader pack invalid: %s", path);
+			glcCloseShaderPack(pack);
+			return -1;
+		}
+	}
+	return 1;
+}
+
+/*	glcFindShaderSource()
+	Returns: 1 (success) or -1 (failure)
+	pack - shader pack opened by glcOpenShaderPack
+	name - name the source was packed under
+	source - receives a pointer into the pack, valid until it is closed
+	length - receives the length of the source */
+int glcFindShaderSource(const glcShaderPack* pack, const char* name, const char** source, GLint* length)
+{
+	unsigned int low = 0, high = pack->count;
+
+	while(low < high)
+	{
+		unsigned int middle = low + (high - low) / 2;
+		const unsigned int* entry = glc_packEntry(pack, middle);
+		int order = strcmp(name, (const char*)pack->data + entry[0]);
+		if(!order)
+		{
+			*source = (const char*)pack->data + entry[2];
+			*length = (GLint)entry[3];
+			return 1;
+		}
+		if(order < 0)
+			high = middle;
+		else
+			low = middle + 1;
+	}
+	GLC_LOG(GLC_ERROR_NOT_FOUND, "Shader not found in pack: %s", name);
+	return -1;
+}
+
+/*	glcWriteShaderPack()
+	Returns: 1 (success) or -1 (failure)
+	path - path of the pack file to write
+	names - name of each source, as passed to glcFindShaderSource later
+	sources - shader sources
+	lengths - length of each source, or NULL if they are null terminated
+	count - amount of sources */
+int glcWriteShaderPack(const char* path, const char* const* names, const char* const* sources, const GLint* lengths, int count)
+{
+	int i, j, written = 1;
+	unsigned int offset, header[3];
+	int* order;
+	FILE* file;
+
+	if(count < 0 || !(order = (int*)malloc((count + 1) * sizeof(int))))
+	{
+		GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when writing shader pack.");
+		return -1;
+	}
+	/* insertion sort by name, packs are built offline */
+	for(i = 0; i < count; i++)
+	{
+		for(j = i; j > 0 && strcmp(names[order[j - 1]], names[i]) > 0; j--)
+			order[j] = order[j - 1];
+		order[j] = i;
+	}
+	if(!(file = fopen(path, "wb")))
+	{
+		GLC_LOG(GLC_ERROR_FILE, "Error opening shader pack: %s", path);
+		free(order);
+		return -1;
+	}
+	header[0] = GLC_PACK_MAGIC;
+	header[1] = GLC_PACK_VERSION;
+	header[2] = (unsigned int)count;
+	written &= fwrite(header, sizeof(header), 1, file) == 1;
+	offset = 12 + 16 * (unsigned int)count;
+	for(i = 0; i < count; i++)
+	{
+		unsigned int entry[4];
+		int k = order[i];
+		entry[0] = offset;
+		entry[1] = (unsigned int)strlen(names[k]);
+		entry[2] = entry[0] + entry[1] + 1;
+		entry[3] = (unsigned int)(lengths ? lengths[k] : (GLint)strlen(sources[k]));
+		offset = entry[2] + entry[3] + 1;
+		written &= fwrite(entry, sizeof(entry), 1, file) == 1;
+	}
+	for(i = 0; i < count; i++)
+	{
+		int k = order[i];
+		size_t length = lengths ? (size_t)lengths[k] : strlen(sources[k]);
+		written &= fwrite(names[k], 1, strlen(names[k]) + 1, file) == strlen(names[k]) + 1;
+		written &= fwrite(sources[k], 1, length, file) == length;
+		written &= fputc('\0', file) != EOF;
+	}
+	free(order);
+	if(fclose(file) != 0 || !written)
+	{
+		GLC_LOG(GLC_ERROR_FILE, "Error writing shader pack: %s", path);
+		remove(path);
+		return -1;
+	}
+	return 1;
+}
+
+/*	Uniform handles
+	A glcUniformHandle is a program/location pair resolved once with
+	glcGetUniformHandle(). The glcUniform* setters taking a handle mirror the
+	glUniform* family one to one: no name lookup, no varargs and no validation
+	unless GLC_VALIDATE_UNIFORMS is defined.
+	The program is bound through glcUseProgram, or not at all when
+	GLC_DIRECT_STATE_ACCESS is defined.
+	Setting through a handle whose location is -1 is a no-op, as in GL. */
+typedef struct glcUniformHandle
+{
+	GLuint program;
+	GLint location;
+} glcUniformHandle;
+
+/*	glcGetUniformHandle()
+	Returns: handle to the uniform, with location -1 if it is not active
+	program - shader program handle
+	name - name of uniform */
+glcUniformHandle glcGetUniformHandle(GLuint program, const char* name)
+{
+	glcUniformHandle handle;
+
+	handle.program = program;
+	handle.location = glcGetUniformLocation(program, name);
+	if(handle.location == -1)
+		GLC_LOG(GLC_ERROR_NOT_FOUND, "Uniform name invalid: %s", name);
+	return handle;
+}
+
+/*	glcGetUniformResource()
+	Returns: the declaration of the uniform behind a handle, or NULL
+	h - uniform handle, possibly of an array element */
+const glcProgramResource* glcGetUniformResource(glcUniformHandle h)
+{
+	glcProgramInfo* info = glc_getProgram(h.program);
+
+	if(!info || h.location < 0 || h.location >= info->locationCount || info->locationResources[h.location] == -1)
+		return NULL;
+	return &info->resources[info->locationResources[h.location]];
+}
+
+/*	Uniform shadow and deferred uniforms
+	A program put in filtered or deferred mode with glcSetUniformMode() keeps
+	a shadow copy of all of its uniform values, and the glcUniform* and
+	glcSetUniform* setters compare every value with it first; setting a value
+	that is already there costs a compare and nothing else. In filtered mode
+	(GLC_UNIFORMS_FILTERED) the elements that did change are uploaded at once.
+	In deferred mode (GLC_UNIFORMS_DEFERRED, also glcDeferUniforms()) they are
+	only marked, and glcFlushUniforms() uploads them right before a draw,
+	coalescing consecutive array elements into one call. Either way the
+	application must not set the program's uniforms with glUniform* behind
+	glc's back. */
+enum
+{
+	GLC_UNIFORM_FLOAT, GLC_UNIFORM_VEC2, GLC_UNIFORM_VEC3, GLC_UNIFORM_VEC4,
+	GLC_UNIFORM_INT, GLC_UNIFORM_IVEC2, GLC_UNIFORM_IVEC3, GLC_UNIFORM_IVEC4,
+	GLC_UNIFORM_UINT, GLC_UNIFORM_UVEC2, GLC_UNIFORM_UVEC3, GLC_UNIFORM_UVEC4,
+	GLC_UNIFORM_MAT2, GLC_UNIFORM_MAT3, GLC_UNIFORM_MAT4,
+	GLC_UNIFORM_MAT2X3, GLC_UNIFORM_MAT3X2, GLC_UNIFORM_MAT2X4,
+	GLC_UNIFORM_MAT4X2, GLC_UNIFORM_MAT3X4, GLC_UNIFORM_MAT4X3,
+	GLC_UNIFORM_KINDS
+};
+
+/* columns and rows of each kind, every component is 4 bytes */
+static const unsigned char glc_kindShape[GLC_UNIFORM_KINDS][2] =
+{
+	{1, 1}, {1, 2}, {1, 3}, {1, 4},
+	{1, 1}, {1, 2}, {1, 3}, {1, 4},
+	{1, 1}, {1, 2}, {1, 3}, {1, 4},
+	{2, 2}, {3, 3}, {4, 4},
+	{2, 3}, {3, 2}, {2, 4},
+	{4, 2}, {3, 4}, {4, 3}
+};
+
+enum
+{
+	GLC_UNIFORMS_DIRECT, GLC_UNIFORMS_FILTERED, GLC_UNIFORMS_DEFERRED
+};
+
+#define GLC_SLOT_DIRTY 1	/* changed since the last flush, deferred mode */
+#define GLC_SLOT_MATERIAL 2	/* written by glcApplyMaterial */
+
+static int glc_kindOfType(GLenum type)
+{
+	switch(type)
+	{
+	case GL_FLOAT:				return GLC_UNIFORM_FLOAT;
+	case GL_FLOAT_VEC2:			return GLC_UNIFORM_VEC2;
+	case GL_FLOAT_VEC3:			return GLC_UNIFORM_VEC3;
+	case GL_FLOAT_VEC4:			return GLC_UNIFORM_VEC4;
+	case GL_INT: case GL_BOOL:	return GLC_UNIFORM_INT;
+	case GL_INT_VEC2: case GL_BOOL_VEC2:	return GLC_UNIFORM_IVEC2;
+	case GL_INT_VEC3: case GL_BOOL_VEC3:	return GLC_UNIFORM_IVEC3;
+	case GL_INT_VEC4: case GL_BOOL_VEC4:	return GLC_UNIFORM_IVEC4;
+	case GL_UNSIGNED_INT:		return GLC_UNIFORM_UINT;
+	case GL_UNSIGNED_INT_VEC2:	return GLC_UNIFORM_UVEC2;
+	case GL_UNSIGNED_INT_VEC3:	return GLC_UNIFORM_UVEC3;
+	case GL_UNSIGNED_INT_VEC4:	return GLC_UNIFORM_UVEC4;
+	case GL_FLOAT_MAT2:			return GLC_UNIFORM_MAT2;
+	case GL_FLOAT_MAT3:			return GLC_UNIFORM_MAT3;
+	case GL_FLOAT_MAT4:			return GLC_UNIFORM_MAT4;
+	case GL_FLOAT_MAT2x3:		return GLC_UNIFORM_MAT2X3;
+	case GL_FLOAT_MAT3x2:		return GLC_UNIFORM_MAT3X2;
+	case GL_FLOAT_MAT2x4:		return GLC_UNIFORM_MAT2X4;
+	case GL_FLOAT_MAT4x2:		return GLC_UNIFORM_MAT4X2;
+	case GL_FLOAT_MAT3x4:		return GLC_UNIFORM_MAT3X4;
+	case GL_FLOAT_MAT4x3:		return GLC_UNIFORM_MAT4X3;
+	default:
+	{
+		/* samplers and images are set as ints, doubles are not shadowed */
+		int columns, rows;
+		return glc_typeShape(type, &columns, &rows) ? -1 : GLC_UNIFORM_INT;
+	}
+	}
+}
+
+/*	Define GLC_VALIDATE_UNIFORMS to check every set through a handle against
+	the reflected declaration of the uniform, logging sets of the wrong type
+	and arrays passed to non-array uniforms, which GL rejects with no more
+	than a GL_INVALID_OPERATION. */
+#ifdef GLC_VALIDATE_UNIFORMS
+static const char* const glc_kindNames[GLC_UNIFORM_KINDS] =
+{
+	"float", "vec2", "vec3", "vec4", "int", "ivec2", "ivec3", "ivec4",
+	"uint", "uvec2", "uvec3", "uvec4", "mat2", "mat3", "mat4",
+	"mat2x3", "mat3x2", "mat2x4", "mat4x2", "mat3x4", "mat4x3"
+};
+
+static void glc_validateUniform(glcUniformHandle h, int kind, GLsizei count)
+{
+	int declared;
+	const glcProgramResource* r;
+	glcProgramInfo* info;
+
+	if(h.location < 0 || !(info = glc_findProgram(h.program)))
+		return;
+	if(h.location >= info->locationCount || info->locationResources[h.location] == -1)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Program %u has no uniform at location %d.", h.program, h.location);
+		return;
+	}
+	r = &info->resources[info->locationResources[h.location]];
+	declared = glc_kindOfType(r->type);
+	/* bools take float, int and uint values alike */
+	if(declared != kind && !(r->type >= GL_BOOL && r->type <= GL_BOOL_VEC4 && kind < GLC_UNIFORM_MAT2 && kind % 4 == declared % 4))
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Uniform %s is declared as type 0x%X, set as %s.", r->name, r->type, glc_kindNames[kind]);
+	else if(r->size == 1 && count > 1)
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Uniform %s is not an array, set with %d values.", r->name, (int)count);
+}
+
+#define GLC_VALIDATE_UNIFORM(h, kind, count) glc_validateUniform(h, kind, count)
+#else
+#define GLC_VALIDATE_UNIFORM(h, kind, count) ((void)0)
+#endif
+
+#ifdef GLC_DIRECT_STATE_ACCESS
+#define GLC_UNIFORM_CALL(suffix, ...) (GLC_STAT(frame.uniformCalls++), glProgramUniform##suffix(h.program, h.location, __VA_ARGS__))
+#else
+#define GLC_UNIFORM_CALL(suffix, ...) (glcUseProgram(h.program), GLC_STAT(frame.uniformCalls++), glUniform##suffix(h.location, __VA_ARGS__))
+#endif
+
+/* Issues the glUniform*v call matching a kind. h.program must be current
+   unless GLC_DIRECT_STATE_ACCESS is defined. */
+static void glc_uploadUniform(glcUniformHandle h, int kind, GLsizei count, const void* data)
+{
+	const GLfloat* f = (const GLfloat*)data;
+	const GLint* i = (const GLint*)data;
+	const GLuint* ui = (const GLuint*)data;
+
+	switch(kind)
+	{
+	case GLC_UNIFORM_FLOAT:		GLC_UNIFORM_CALL(1fv, count, f); break;
+	case GLC_UNIFORM_VEC2:		GLC_UNIFORM_CALL(2fv, count, f); break;
+	case GLC_UNIFORM_VEC3:		GLC_UNIFORM_CALL(3fv, count, f); break;
+	case GLC_UNIFORM_VEC4:		GLC_UNIFORM_CALL(4fv, count, f); break;
+	case GLC_UNIFORM_INT:		GLC_UNIFORM_CALL(1iv, count, i); break;
+	case GLC_UNIFORM_IVEC2:		GLC_UNIFORM_CALL(2iv, count, i); break;
+	case GLC_UNIFORM_IVEC3:		GLC_UNIFORM_CALL(3iv, count, i); break;
+	case GLC_UNIFORM_IVEC4:		GLC_UNIFORM_CALL(4iv, count, i); break;
+	case GLC_UNIFORM_UINT:		GLC_UNIFORM_CALL(1uiv, count, ui); break;
+	case GLC_UNIFORM_UVEC2:		GLC_UNIFORM_CALL(2uiv, count, ui); break;
+	case GLC_UNIFORM_UVEC3:		GLC_UNIFORM_CALL(3uiv, count, ui); break;
+	case GLC_UNIFORM_UVEC4:		GLC_UNIFORM_CALL(4uiv, count, ui); break;
+	case GLC_UNIFORM_MAT2:		GLC_UNIFORM_CALL(Matrix2fv, count, GL_FALSE, f); break;
+	case GLC_UNIFORM_MAT3:		GLC_UNIFORM_CALL(Matrix3fv, count, GL_FALSE, f); break;
+	case GLC_UNIFORM_MAT4:		GLC_UNIFORM_CALL(Matrix4fv, count, GL_FALSE, f); break;
+	case GLC_UNIFORM_MAT2X3:	GLC_UNIFORM_CALL(Matrix2x3fv, count, GL_FALSE, f); break;
+	case GLC_UNIFORM_MAT3X2:	GLC_UNIFORM_CALL(Matrix3x2fv, count, GL_FALSE, f); break;
+	case GLC_UNIFORM_MAT2X4:	GLC_UNIFORM_CALL(Matrix2x4fv, count, GL_FALSE, f); break;
+	case GLC_UNIFORM_MAT4X2:	GLC_UNIFORM_CALL(Matrix4x2fv, count, GL_FALSE, f); break;
+	case GLC_UNIFORM_MAT3X4:	GLC_UNIFORM_CALL(Matrix3x4fv, count, GL_FALSE, f); break;
+	case GLC_UNIFORM_MAT4X3:	GLC_UNIFORM_CALL(Matrix4x3fv, count, GL_FALSE, f); break;
+	}
+}
+
+/* Lays out the shadow copy of a program and fills it with the values
+   currently held by GL, so the first set of an unchanged value is a no-op.
+   The per location data is split into arrays that share one allocation,
+   so the compare of a set only touches the offsets, sizes and kinds. */
+static int glc_buildShadow(glcProgramInfo* info)
+{
+	int i, j, k, elements, size = 0, count = info->locationCount;
+	GLint location;
+	const glcProgramResource* r;
+
+	free(info->slotOffsets);
+	free(info->shadow);
+	info->slotOffsets = NULL;
+	info->shadow = NULL;
+	info->slotCount = 0;
+	info->dirtyCount = 0;
+	info->materialHash = 0;
+	info->slotOffsets = (int*)malloc(count * (2 * sizeof(int) + 3) + 1);
+	if(!info->slotOffsets)
+		goto fail;
+	info->slotRemaining = info->slotOffsets + count;
+	info->slotSizes = (unsigned char*)(info->slotRemaining + count);
+	info->slotKinds = info->slotSizes + count;
+	info->slotFlags = info->slotKinds + count;
+	for(i = 0; i < count; i++)
+		info->slotOffsets[i] = -1;
+	memset(info->slotFlags, 0, count);
+	info->slotCount = count;
+
+	for(k = 0; k < 2; k++)
+	{
+		/* first pass lays out the slots, second reads back the values */
+		for(i = 0, r = info->resources; i < info->resourceCount; i++, r++)
+		{
+			int kind;
+			if(r->interface != GLC_RESOURCE_UNIFORM || r->location == -1 || (kind = glc_kindOfType(r->type)) == -1)
+				continue;
+			/* element locations need not be consecutive before GL 4.3 */
+			for(elements = 0, location = r->location; elements < r->size && location != -1; elements++)
+				location = info->locationNext[location];
+			for(j = 0, location = r->location; j < elements; j++, location = info->locationNext[location])
+			{
+				if(!k)
+				{
+					info->slotOffsets[location] = size;
+					info->slotSizes[location] = (unsigned char)(glc_kindShape[kind][0] * glc_kindShape[kind][1] * 4);
+					info->slotRemaining[location] = elements - j;
+					info->slotKinds[location] = (unsigned char)kind;
+					size += info->slotSizes[location];
+				}
+				else if(kind >= GLC_UNIFORM_UINT && kind <= GLC_UNIFORM_UVEC4)
+					glGetUniformuiv(info->program, location, (GLuint*)(info->shadow + info->slotOffsets[location]));
+				else if(kind >= GLC_UNIFORM_INT && kind <= GLC_UNIFORM_IVEC4)
+					glGetUniformiv(info->program, location, (GLint*)(info->shadow + info->slotOffsets[location]));
+				else
+					glGetUniformfv(info->program, location, (GLfloat*)(info->shadow + info->slotOffsets[location]));
+			}
+		}
+		if(!k && !(info->shadow = (unsigned char*)calloc(size + 1, 1)))
+			goto fail;
+	}
+	return 1;
+
+fail:
+	GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when building uniform shadow copy.");
+	free(info->slotOffsets);
+	info->slotOffsets = NULL;
+	info->slotCount = 0;
+	return -1;
+}
+
+/* Compares two uniform elements, a multiple of 4 and at most 64 bytes. */
+static int glc_sameValue(const unsigned char* a, const unsigned char* b, int size)
+{
+#if defined(GLC_SSE)
+	for(; size >= 16; size -= 16, a += 16, b += 16)
+	{
+		if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)a), _mm_loadu_si128((const __m128i*)b))) != 0xFFFF)
+			return 0;
+	}
+#elif defined(GLC_NEON) && defined(__aarch64__)
+	for(; size >= 16; size -= 16, a += 16, b += 16)
+	{
+		if(vminvq_u8(vceqq_u8(vld1q_u8(a), vld1q_u8(b))) != 0xFF)
+			return 0;
+	}
+#endif
+	return !size || !memcmp(a, b, size);
+}
+
+/* Stores a value into the shadow copy of a filtered or deferred program.
+   A filtered program uploads the changed elements at once, a deferred one
+   marks them for glcFlushUniforms. Returns 1 if the set was handled, 0 if
+   it must go to GL directly. */
+static int glc_interceptUniform(glcUniformHandle h, int kind, GLsizei count, GLboolean transpose, const void* value)
+{
+	int i, r, c, size, columns, rows, first = -1, last = -1;
+	GLint location;
+	GLfloat transposed[16];
+	const unsigned char* src = (const unsigned char*)value;
+	glcProgramInfo* info = glc_findProgram(h.program);
+
+	if(!info || info->uniformMode == GLC_UNIFORMS_DIRECT)
+		return 0;
+	if(h.location < 0)
+		return 1;
+	columns = glc_kindShape[kind][0];
+	rows = glc_kindShape[kind][1];
+	size = columns * rows * 4;
+	/* anything GL would reject is left for GL to report */
+	if(h.location >= info->slotCount || count < 1)
+		return 0;
+	location = h.location;
+	if(info->slotOffsets[location] < 0 || info->slotSizes[location] != size || count > info->slotRemaining[location])
+		return 0;
+
+	for(i = 0; i < count; i++, location = info->locationNext[location], src += size)
+	{
+		const unsigned char* element = src;
+		unsigned char* stored = info->shadow + info->slotOffsets[location];
+		if(transpose)
+		{
+			for(c = 0; c < columns; c++)
+				for(r = 0; r < rows; r++)
+					transposed[c * rows + r] = ((const GLfloat*)src)[r * columns + c];
+			element = (const unsigned char*)transposed;
+		}
+		if(info->slotKinds[location] == kind && glc_sameValue(stored, element, size))
+			continue;
+		memcpy(stored, element, size);
+		info->slotKinds[location] = (unsigned char)kind;
+		/* a material value was overwritten, the material must be applied again */
+		if(info->slotFlags[location] & GLC_SLOT_MATERIAL)
+			info->materialHash = 0;
+		if(first == -1)
+		{
+			first = i;
+			h.location = location;
+		}
+		last = i;
+		if(info->uniformMode == GLC_UNIFORMS_DEFERRED && !(info->slotFlags[location] & GLC_SLOT_DIRTY))
+		{
+			info->slotFlags[location] |= GLC_SLOT_DIRTY;
+			info->dirtyCount++;
+		}
+	}
+	if(first == -1)
+		GLC_STAT(frame.redundantUniforms++);
+	else if(info->uniformMode == GLC_UNIFORMS_FILTERED)
+	{
+		/* the elements of an array lie back to back in the shadow */
+		glc_uploadUniform(h, kind, last - first + 1, info->shadow + info->slotOffsets[h.location]);
+	}
+	return 1;
+}
+
+/*	glcFlushUniforms()
+	Returns: 1 (success) or -1 (failure)
+	program - shader program handle
+	Uploads every uniform of a deferred program whose value changed since the
+	last flush. Call it before drawing with the program. */
+int glcFlushUniforms(GLuint program)
+{
+	GLint i, location, next, last, run;
+	glcUniformHandle h;
+	glcProgramInfo* info = glc_findProgram(program);
+
+	if(!info || info->uniformMode != GLC_UNIFORMS_DEFERRED)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Program %u is not in deferred uniform mode.", program);
+		return -1;
+	}
+	if(!info->dirtyCount)
+		return 1;
+	h.program = program;
+	for(location = 0; location < info->slotCount; location++)
+	{
+		if(!(info->slotFlags[location] & GLC_SLOT_DIRTY))
+			continue;
+		/* the following dirty elements of the array go in the same call */
+		for(run = 1, last = location; run < info->slotRemaining[location]; run++, last = next)
+		{
+			next = info->locationNext[last];
+			if(!(info->slotFlags[next] & GLC_SLOT_DIRTY) || info->slotKinds[next] != info->slotKinds[location])
+				break;
+		}
+		h.location = location;
+		glc_uploadUniform(h, info->slotKinds[location], run, info->shadow + info->slotOffsets[location]);
+		for(i = 0, next = location; i < run; i++, next = info->locationNext[next])
+			info->slotFlags[next] &= ~GLC_SLOT_DIRTY;
+	}
+	info->dirtyCount = 0;
+	return 1;
+}
+
+/*	glcSetUniformMode()
+	Returns: 1 (success) or -1 (failure)
+	program - linked shader program handle
+	mode - GLC_UNIFORMS_DIRECT, GLC_UNIFORMS_FILTERED or GLC_UNIFORMS_DEFERRED
+	Leaving deferred mode flushes what is pending. */
+int glcSetUniformMode(GLuint program, int mode)
+{
+	glcProgramInfo* info = glc_getProgram(program);
+
+	if(!info)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Program %u is not linked.", program);
+		return -1;
+	}
+	if(mode < GLC_UNIFORMS_DIRECT || mode > GLC_UNIFORMS_DEFERRED)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Uniform mode invalid. Got %d.", mode);
+		return -1;
+	}
+	if(mode == info->uniformMode)
+		return 1;
+	if(info->uniformMode == GLC_UNIFORMS_DEFERRED)
+		glcFlushUniforms(program);
+	/* the shadow stays valid while filtered or deferred, not while direct */
+	if(info->uniformMode == GLC_UNIFORMS_DIRECT)
+	{
+		if(glc_buildShadow(info) == -1)
+			return -1;
+		GLC_ADD_INT(&glc_uniformHooks, 1);
+	}
+	else if(mode == GLC_UNIFORMS_DIRECT)
+		GLC_ADD_INT(&glc_uniformHooks, -1);
+	info->uniformMode = mode;
+	return 1;
+}
+
+/*	glcDeferUniforms()
+	Returns: 1 (success) or -1 (failure)
+	program - linked shader program handle
+	enable - GL_TRUE to batch uniform sets until glcFlushUniforms,
+		GL_FALSE to flush what is pending and go back to immediate sets */
+int glcDeferUniforms(GLuint program, GLboolean enable)
+{
+	return glcSetUniformMode(program, enable ? GLC_UNIFORMS_DEFERRED : GLC_UNIFORMS_DIRECT);
+}
+
+#define GLC_DEFINE_UNIFORM(suffix, kind, T, params, ...) \
+void glcUniform##suffix params \
+{ \
+	GLC_VALIDATE_UNIFORM(h, kind, 1); \
+	if(GLC_LOAD_INT(&glc_uniformHooks)) \
+	{ \
+		const T value[] = { __VA_ARGS__ }; \
+		if(glc_interceptUniform(h, kind, 1, GL_FALSE, value)) \
+			return; \
+	} \
+	GLC_UNIFORM_CALL(suffix, __VA_ARGS__); \
+}
+
+#define GLC_DEFINE_UNIFORM_ARRAY(suffix, kind, T) \
+void glcUniform##suffix(glcUniformHandle h, GLsizei count, const T* value) \
+{ \
+	GLC_VALIDATE_UNIFORM(h, kind, count); \
+	if(GLC_LOAD_INT(&glc_uniformHooks) && glc_interceptUniform(h, kind, count, GL_FALSE, value)) \
+		return; \
+	GLC_UNIFORM_CALL(suffix, count, value); \
+}
+
+#define GLC_DEFINE_UNIFORM_TYPE(suffix, T, kind) \
+GLC_DEFINE_UNIFORM(1##suffix, kind, T, (glcUniformHandle h, T x), x) \
+GLC_DEFINE_UNIFORM(2##suffix, kind + 1, T, (glcUniformHandle h, T x, T y), x, y) \
+GLC_DEFINE_UNIFORM(3##suffix, kind + 2, T, (glcUniformHandle h, T x, T y, T z), x, y, z) \
+GLC_DEFINE_UNIFORM(4##suffix, kind + 3, T, (glcUniformHandle h, T x, T y, T z, T w), x, y, z, w) \
+GLC_DEFINE_UNIFORM_ARRAY(1##suffix##v, kind, T) \
+GLC_DEFINE_UNIFORM_ARRAY(2##suffix##v, kind + 1, T) \
+GLC_DEFINE_UNIFORM_ARRAY(3##suffix##v, kind + 2, T) \
+GLC_DEFINE_UNIFORM_ARRAY(4##suffix##v, kind + 3, T)
+
+#define GLC_DEFINE_UNIFORM_MATRIX(suffix, kind) \
+void glcUniformMatrix##suffix##fv(glcUniformHandle h, GLsizei count, GLboolean transpose, const GLfloat* value) \
+{ \
+	GLC_VALIDATE_UNIFORM(h, kind, count); \
+	if(GLC_LOAD_INT(&glc_uniformHooks) && glc_interceptUniform(h, kind, count, transpose, value)) \
+		return; \
+	GLC_UNIFORM_CALL(Matrix##suffix##fv, count, transpose, value); \
+}
+
+/*	glcUniform{1,2,3,4}{f,i,ui}[v]()
+	glcUniformMatrix{2,3,4,2x3,3x2,2x4,4x2,3x4,4x3}fv()
+	h - uniform handle
+	Remaining parameters are those of the matching glUniform* call. */
+GLC_DEFINE_UNIFORM_TYPE(f, GLfloat, GLC_UNIFORM_FLOAT)
+GLC_DEFINE_UNIFORM_TYPE(i, GLint, GLC_UNIFORM_INT)
+GLC_DEFINE_UNIFORM_TYPE(ui, GLuint, GLC_UNIFORM_UINT)
+GLC_DEFINE_UNIFORM_MATRIX(2, GLC_UNIFORM_MAT2)
+GLC_DEFINE_UNIFORM_MATRIX(3, GLC_UNIFORM_MAT3)
+GLC_DEFINE_UNIFORM_MATRIX(4, GLC_UNIFORM_MAT4)
+GLC_DEFINE_UNIFORM_MATRIX(2x3, GLC_UNIFORM_MAT2X3)
+GLC_DEFINE_UNIFORM_MATRIX(3x2, GLC_UNIFORM_MAT3X2)
+GLC_DEFINE_UNIFORM_MATRIX(2x4, GLC_UNIFORM_MAT2X4)
+GLC_DEFINE_UNIFORM_MATRIX(4x2, GLC_UNIFORM_MAT4X2)
+GLC_DEFINE_UNIFORM_MATRIX(3x4, GLC_UNIFORM_MAT3X4)
+GLC_DEFINE_UNIFORM_MATRIX(4x3, GLC_UNIFORM_MAT4X3)
+
+#define GLC_DEFINE_SET_UNIFORM(suffix, params, ...) \
+int glcSetUniform##suffix params \
+{ \
+	glcUniformHandle h = glcGetUniformHandle(program, name); \
+	if(h.location == -1) \
+		return -1; \
+	glcUniform##suffix(h, __VA_ARGS__); \
+	return 1; \
+}
+
+#define GLC_DEFINE_SET_UNIFORM_TYPE(suffix, T) \
+GLC_DEFINE_SET_UNIFORM(1##suffix, (GLuint program, const char* name, T x), x) \
+GLC_DEFINE_SET_UNIFORM(2##suffix, (GLuint program, const char* name, T x, T y), x, y) \
+GLC_DEFINE_SET_UNIFORM(3##suffix, (GLuint program, const char* name, T x, T y, T z), x, y, z) \
+GLC_DEFINE_SET_UNIFORM(4##suffix, (GLuint program, const char* name, T x, T y, T z, T w), x, y, z, w) \
+GLC_DEFINE_SET_UNIFORM(1##suffix##v, (GLuint program, const char* name, GLsizei count, const T* value), count, value) \
+GLC_DEFINE_SET_UNIFORM(2##suffix##v, (GLuint program, const char* name, GLsizei count, const T* value), count, value) \
+GLC_DEFINE_SET_UNIFORM(3##suffix##v, (GLuint program, const char* name, GLsizei count, const T* value), count, value) \
+GLC_DEFINE_SET_UNIFORM(4##suffix##v, (GLuint program, const char* name, GLsizei count, const T* value), count, value)
+
+#define GLC_DEFINE_SET_UNIFORM_MATRIX(suffix) \
+GLC_DEFINE_SET_UNIFORM(Matrix##suffix##fv, (GLuint program, const char* name, GLsizei count, GLboolean transpose, const GLfloat* value), count, transpose, value)
+
+/*	glcSetUniform{1,2,3,4}{f,i,ui}[v]()
+	glcSetUniformMatrix{2,3,4,2x3,3x2,2x4,4x2,3x4,4x3}fv()
+	Returns: 1 (success) or -1 (failure)
+	program - shader program handle
+	name - name of uniform
+	Remaining parameters are those of the matching glUniform* call.
+	Type and dimension are part of the function name, so unlike
+	glcSetUniformx there is no varargs promotion or runtime dispatch. */
+GLC_DEFINE_SET_UNIFORM_TYPE(f, GLfloat)
+GLC_DEFINE_SET_UNIFORM_TYPE(i, GLint)
+GLC_DEFINE_SET_UNIFORM_TYPE(ui, GLuint)
+GLC_DEFINE_SET_UNIFORM_MATRIX(2)
+GLC_DEFINE_SET_UNIFORM_MATRIX(3)
+GLC_DEFINE_SET_UNIFORM_MATRIX(4)
+GLC_DEFINE_SET_UNIFORM_MATRIX(2x3)
+GLC_DEFINE_SET_UNIFORM_MATRIX(3x2)
+GLC_DEFINE_SET_UNIFORM_MATRIX(2x4)
+GLC_DEFINE_SET_UNIFORM_MATRIX(4x2)
+GLC_DEFINE_SET_UNIFORM_MATRIX(3x4)
+GLC_DEFINE_SET_UNIFORM_MATRIX(4x3)
+
+/*	glcSetUniformx()
+	Returns: 1 (success) or -1 (failure)
+	program - shader program handle
+	name - name of uniform
+	type - data type to be sent to shader
+		Accepted values are: GL_FLOAT, GL_INT, GL_UNSIGNED_INT
+	dimension - value of 1-4 to show size of uniform 
+	... - 1 to 4 values for uniform */
+int glcSetUniformx(GLuint program, const char* name, int type, int dimension, ...)
+{
+	int i;
+	union { GLfloat f[4]; GLint i[4]; GLuint ui[4]; } data;
+	glcUniformHandle h;
+	va_list vl;
+
+	if(type != GL_FLOAT && type != GL_INT && type != GL_UNSIGNED_INT)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Type invalid. Must be GL_FLOAT, GL_INT or GL_UNSIGNED_INT. Got 0x%X.", type);
+		return -1;
+	}
+	if(dimension < 1 || dimension > 4)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Dimension invalid. Must be 1-4. Got %d.", dimension);
+		return -1;
+	}
+	h = glcGetUniformHandle(program, name);
+	if(h.location == -1)
+		return -1;
+
+	va_start(vl, dimension);
+	for(i = 0; i < dimension; i++)
+	{
+		if(type == GL_FLOAT)
+			data.f[i] = (GLfloat)va_arg(vl, double);
+		else if(type == GL_INT)
+			data.i[i] = (GLint)va_arg(vl, int);
+		else
+			data.ui[i] = (GLuint)va_arg(vl, unsigned int);
+	}
+	va_end(vl);
+
+	if(dimension == 1)
+		(type == GL_FLOAT)	? glcUniform1fv(h, 1, data.f) :
+		(type == GL_INT)	? glcUniform1iv(h, 1, data.i) :
+		glcUniform1uiv(h, 1, data.ui);
+	else if(dimension == 2)
+		(type == GL_FLOAT)	? glcUniform2fv(h, 1, data.f) :
+		(type == GL_INT)	? glcUniform2iv(h, 1, data.i) :
+		glcUniform2uiv(h, 1, data.ui);
+	else if(dimension == 3)
+		(type == GL_FLOAT)	? glcUniform3fv(h, 1, data.f) :
+		(type == GL_INT)	? glcUniform3iv(h, 1, data.i) :
+		glcUniform3uiv(h, 1, data.ui);
+	else
+		(type == GL_FLOAT)	? glcUniform4fv(h, 1, data.f) :
+		(type == GL_INT)	? glcUniform4iv(h, 1, data.i) :
+		glcUniform4uiv(h, 1, data.ui);
+
+	return 1;
+}
+
+/*	glcSetUniformxv()
+	Returns: 1 (success) or -1 (failure)
+	program - shader program handle
+	name - name of uniform
+	type - data type to be sent to shader
+		Accepted values are: GL_FLOAT, GL_INT, GL_UNSIGNED_INT
+	dimension - value of 1-4 to show size of uniform array element
+	amount - amount of elements in uniform array to set
+	uniform - pointer to contiguous uniform values*/
+int glcSetUniformxv(GLuint program, const char* name, int type, int dimension, int amount, const void* uniform)
+{
+	glcUniformHandle h;
+
+	if(type != GL_FLOAT && type != GL_INT && type != GL_UNSIGNED_INT)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Type invalid. Must be GL_FLOAT, GL_INT or GL_UNSIGNED_INT. Got 0x%X.", type);
+		return -1;
+	}
+	if(dimension < 1 || dimension > 4)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Dimension invalid. Must be 1-4. Got %d.", dimension);
+		return -1;
+	}
+	if(amount <= 0)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Amount invalid. Must be larger than 0. Got %d", amount);
+		return -1;
+	}
+	h = glcGetUniformHandle(program, name);
+	if(h.location == -1)
+		return -1;
+
+	if(dimension == 1)
+		(type == GL_FLOAT)	? glcUniform1fv(h, amount, (GLfloat*)uniform) :
+		(type == GL_INT)	? glcUniform1iv(h, amount, (GLint*)uniform) :
+		glcUniform1uiv(h, amount, (GLuint*)uniform);
+	else if(dimension == 2)
+		(type == GL_FLOAT)	? glcUniform2fv(h, amount, (GLfloat*)uniform) :
+		(type == GL_INT)	? glcUniform2iv(h, amount, (GLint*)uniform) :
+		glcUniform2uiv(h, amount, (GLuint*)uniform);
+	else if(dimension == 3)
+		(type == GL_FLOAT)	? glcUniform3fv(h, amount, (GLfloat*)uniform) :
+		(type == GL_INT)	? glcUniform3iv(h, amount, (GLint*)uniform) :
+		glcUniform3uiv(h, amount, (GLuint*)uniform);
+	else
+		(type == GL_FLOAT)	? glcUniform4fv(h, amount, (GLfloat*)uniform) :
+		(type == GL_INT)	? glcUniform4iv(h, amount, (GLint*)uniform) :
+		glcUniform4uiv(h, amount, (GLuint*)uniform);
+
+	return 1;
+}
+
+int glcSetUniformMatx(GLuint program, const char* name, int dimension, int amount, GLboolean transpose, const void* uniform)
+{
+	glcUniformHandle h;
+	if(dimension < 2 || dimension > 4)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Dimension invalid. Must be 2-4. Got %d.", dimension);
+		return -1;
+	}
+	h = glcGetUniformHandle(program, name);
+	if(h.location == -1)
+		return -1;
+
+	if(dimension == 2)
+		glcUniformMatrix2fv(h, amount, transpose, (GLfloat*)uniform);
+	else if(dimension == 3)
+		glcUniformMatrix3fv(h, amount, transpose, (GLfloat*)uniform);
+	else
+		glcUniformMatrix4fv(h, amount, transpose, (GLfloat*)uniform);
+
+	return 1;
+}
+
+/*	Materials
+	A material is a set of uniform values applied together, such as the
+	colors, factors and texture units of one surface. glcApplyMaterial()
+	remembers the material it last applied to a program in filtered or
+	deferred uniform mode, by hash, so consecutive draws with the same
+	material cost one compare instead of a compare per value. Any set that
+	changes one of the material's values, through whichever setter, drops
+	the remembered hash and the next apply goes value by value again, still
+	skipping those that are unchanged. In direct mode every apply uploads. */
+typedef struct glcMaterialValue
+{
+	GLint location;		/* from glcGetUniformLocation */
+	int kind;			/* GLC_UNIFORM_FLOAT to GLC_UNIFORM_MAT4X3 */
+	GLsizei count;		/* array elements */
+	const void* data;	/* count values, matrices column-major */
+} glcMaterialValue;
+
+/*	glcHashMaterial()
+	Returns: 64 bit hash of the locations, kinds and data of the values,
+	never 0
+	values - the material's values
+	count - amount of values
+	Compute it when the material is made or edited, not per draw. */
+unsigned long long glcHashMaterial(const glcMaterialValue* values, int count)
+{
+	int i, kind;
+	unsigned long long hash = 14695981039346656037ull;
+
+	for(i = 0; i < count; i++)
+	{
+		kind = values[i].kind;
+		hash = glc_hashBytes(hash, &values[i].location, sizeof(GLint));
+		hash = glc_hashBytes(hash, &kind, sizeof(int));
+		hash = glc_hashBytes(hash, &values[i].count, sizeof(GLsizei));
+		if(kind >= 0 && kind < GLC_UNIFORM_KINDS && values[i].count > 0)
+			hash = glc_hashBytes(hash, values[i].data, (size_t)values[i].count * glc_kindShape[kind][0] * glc_kindShape[kind][1] * 4);
+	}
+	return hash ? hash : 1;
+}
+
+/*	glcApplyMaterial()
+	Returns: 1 (uploaded), 0 (already current, nothing done) or -1 (failure)
+	program - shader program handle
+	values - the material's values
+	count - amount of values
+	hash - the material's hash from glcHashMaterial, or 0 to hash here */
+int glcApplyMaterial(GLuint program, const glcMaterialValue* values, int count, unsigned long long hash)
+{
+	int i, j;
+	GLint location;
+	glcUniformHandle h;
+	glcProgramInfo* info = glc_getProgram(program);
+
+	if(!info)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Program %u is not linked.", program);
+		return -1;
+	}
+	if(!hash)
+		hash = glcHashMaterial(values, count);
+	if(info->uniformMode != GLC_UNIFORMS_DIRECT && info->materialHash == hash)
+	{
+		GLC_STAT(frame.materialSkips++);
+		return 0;
+	}
+	h.program = program;
+	for(i = 0; i < count; i++)
+	{
+		if(values[i].kind < 0 || values[i].kind >= GLC_UNIFORM_KINDS)
+		{
+			GLC_LOG(GLC_ERROR_INVALID_VALUE, "Material value %d kind invalid. Got %d.", i, values[i].kind);
+			return -1;
+		}
+		h.location = values[i].location;
+		GLC_VALIDATE_UNIFORM(h, values[i].kind, values[i].count);
+		if(!glc_interceptUniform(h, values[i].kind, values[i].count, GL_FALSE, values[i].data))
+			glc_uploadUniform(h, values[i].kind, values[i].count, values[i].data);
+	}
+	if(info->uniformMode == GLC_UNIFORMS_DIRECT)
+		return 1;
+	/* mark the values as the material's only now, its own sets must not drop the hash */
+	for(i = 0; i < count; i++)
+	{
+		location = values[i].location;
+		for(j = 0; location >= 0 && location < info->slotCount && j < values[i].count; j++, location = info->locationNext[location])
+			info->slotFlags[location] |= GLC_SLOT_MATERIAL;
+	}
+	info->materialHash = hash;
+	return 1;
+}
+
+/*	Matrix palettes
+	glcUniformMatrixPalette() uploads an array of matrices gathered straight
+	from the caller's own layout: every stride bytes one matrix, e.g. inside
+	an array of bone structs. Sources may be column-major or row-major 4x4
+	matrices, or 3x4 row-major affine transforms (the top three rows of a
+	4x4) in float or half precision. Each is expanded and transposed to the
+	column-major mat4 the shader sees, four lanes at a time with SSE or NEON
+	where available. Define GLC_NO_SIMD to force the scalar code.
+	glcConvertMatrixPalette() does the same into memory, such as a mapped
+	uniform ring or storage buffer. */
+#define GLC_PALETTE_CHUNK 32	/* matrices converted per upload */
+
+typedef enum glcPaletteFormat
+{
+	GLC_PALETTE_MAT4,				/* 16 floats, column-major */
+	GLC_PALETTE_MAT4_ROW_MAJOR,		/* 16 floats, row-major */
+	GLC_PALETTE_AFFINE,				/* 12 floats, 3 rows of a row-major 4x4 */
+	GLC_PALETTE_AFFINE_HALF			/* 12 halves, 3 rows of a row-major 4x4 */
+} glcPaletteFormat;
+
+static GLsizei glc_paletteSize(int format)
+{
+	switch(format)
+	{
+	case GLC_PALETTE_MAT4:
+	case GLC_PALETTE_MAT4_ROW_MAJOR:	return 16 * sizeof(GLfloat);
+	case GLC_PALETTE_AFFINE:			return 12 * sizeof(GLfloat);
+	case GLC_PALETTE_AFFINE_HALF:		return 12 * sizeof(unsigned short);
+	default:							return 0;
+	}
+}
+
+#if !defined(GLC_F16C) && !defined(GLC_NEON_FP16)
+static GLfloat glc_halfToFloat(unsigned short half)
+{
+	unsigned int sign = (unsigned int)(half & 0x8000) << 16, exponent = (half >> 10) & 0x1F, mantissa = half & 0x3FF, bits;
+	GLfloat value;
+
+	if(exponent == 0x1F)
+		bits = sign | 0x7F800000u | (mantissa << 13);
+	else if(exponent)
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	else if(mantissa)
+	{
+		/* subnormal, renormalised */
+		exponent = 113;
+		while(!(mantissa & 0x400))
+		{
+			mantissa <<= 1;
+			exponent--;
+		}
+		bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+	}
+	else
+		bits = sign;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+/* Loads the 12 halves of an affine transform as floats. */
+static void glc_loadAffineHalf(GLfloat* rows, const unsigned char* src)
+{
+	int i;
+	unsigned short halves[12];
+
+	memcpy(halves, src, sizeof(halves));
+	for(i = 0; i < 12; i++)
+		rows[i] = glc_halfToFloat(halves[i]);
+}
+#endif
+
+/* Writes one column-major mat4 from a source matrix. */
+static void glc_convertPaletteMatrix(GLfloat* dst, const unsigned char* src, int format)
+{
+#if defined(GLC_SSE)
+	__m128 r0, r1, r2, r3;
+
+	if(format == GLC_PALETTE_AFFINE_HALF)
+	{
+#if defined(GLC_F16C)
+		__m128i halves = _mm_loadu_si128((const __m128i*)src);
+		r0 = _mm_cvtph_ps(halves);
+		r1 = _mm_cvtph_ps(_mm_srli_si128(halves, 8));
+		r2 = _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(src + 16)));
+#else
+		GLfloat rows[12];
+		glc_loadAffineHalf(rows, src);
+		r0 = _mm_loadu_ps(rows);
+		r1 = _mm_loadu_ps(rows + 4);
+		r2 = _mm_loadu_ps(rows + 8);
+#endif
+	}
+	else
+	{
+		r0 = _mm_loadu_ps((const float*)src);
+		r1 = _mm_loadu_ps((const float*)(src + 16));
+		r2 = _mm_loadu_ps((const float*)(src + 32));
+	}
+	r3 = (format <= GLC_PALETTE_MAT4_ROW_MAJOR) ? _mm_loadu_ps((const float*)(src + 48)) : _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	if(format != GLC_PALETTE_MAT4)
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	_mm_storeu_ps(dst, r0);
+	_mm_storeu_ps(dst + 4, r1);
+	_mm_storeu_ps(dst + 8, r2);
+	_mm_storeu_ps(dst + 12, r3);
+#elif defined(GLC_NEON)
+	float32x4_t r0, r1, r2, r3;
+	float32x4x2_t low, high;
+	static const float lastRow[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+	if(format == GLC_PALETTE_AFFINE_HALF)
+	{
+#if defined(GLC_NEON_FP16)
+		uint16x8_t halves = vld1q_u16((const unsigned short*)src);
+		r0 = vcvt_f32_f16(vreinterpret_f16_u16(vget_low_u16(halves)));
+		r1 = vcvt_f32_f16(vreinterpret_f16_u16(vget_high_u16(halves)));
+		r2 = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16((const unsigned short*)(src + 16))));
+#else
+		GLfloat rows[12];
+		glc_loadAffineHalf(rows, src);
+		r0 = vld1q_f32(rows);
+		r1 = vld1q_f32(rows + 4);
+		r2 = vld1q_f32(rows + 8);
+#endif
+	}
+	else
+	{
+		r0 = vld1q_f32((const float*)src);
+		r1 = vld1q_f32((const float*)(src + 16));
+		r2 = vld1q_f32((const float*)(src + 32));
+	}
+	r3 = vld1q_f32((format <= GLC_PALETTE_MAT4_ROW_MAJOR) ? (const float*)(src + 48) : lastRow);
+	if(format != GLC_PALETTE_MAT4)
+	{
+		low = vtrnq_f32(r0, r1);
+		high = vtrnq_f32(r2, r3);
+		r0 = vcombine_f32(vget_low_f32(low.val[0]), vget_low_f32(high.val[0]));
+		r1 = vcombine_f32(vget_low_f32(low.val[1]), vget_low_f32(high.val[1]));
+		r2 = vcombine_f32(vget_high_f32(low.val[0]), vget_high_f32(high.val[0]));
+		r3 = vcombine_f32(vget_high_f32(low.val[1]), vget_high_f32(high.val[1]));
+	}
+	vst1q_f32(dst, r0);
+	vst1q_f32(dst + 4, r1);
+	vst1q_f32(dst + 8, r2);
+	vst1q_f32(dst + 12, r3);
+#else
+	int r, c;
+	GLfloat m[16];
+
+	if(format == GLC_PALETTE_AFFINE_HALF)
+		glc_loadAffineHalf(m, src);
+	else
+		memcpy(m, src, glc_paletteSize(format));
+	if(format == GLC_PALETTE_MAT4)
+	{
+		memcpy(dst, m, sizeof(m));
+		return;
+	}
+	if(format != GLC_PALETTE_MAT4_ROW_MAJOR)
+	{
+		m[12] = m[13] = m[14] = 0.0f;
+		m[15] = 1.0f;
+	}
+	for(c = 0; c < 4; c++)
+		for(r = 0; r < 4; r++)
+			dst[c * 4 + r] = m[r * 4 + c];
+#endif
+}
+
+/*	glcConvertMatrixPalette()
+	Returns: 1 (success) or -1 (failure)
+	dst - receives count column-major mat4
+	dstStride - bytes between matrices in dst, or 0 for tightly packed
+	src - first source matrix
+	srcStride - bytes between source matrices, or 0 for tightly packed
+	count - amount of matrices
+	format - layout of the source matrices, a glcPaletteFormat */
+int glcConvertMatrixPalette(void* dst, GLsizei dstStride, const void* src, GLsizei srcStride, GLsizei count, int format)
+{
+	GLsizei i, size = glc_paletteSize(format);
+	unsigned char* out = (unsigned char*)dst;
+	const unsigned char* in = (const unsigned char*)src;
+
+	if(!size)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Palette format invalid. Got %d.", format);
+		return -1;
+	}
+	if(!dstStride)
+		dstStride = 16 * sizeof(GLfloat);
+	if(!srcStride)
+		srcStride = size;
+	for(i = 0; i < count; i++, out += dstStride, in += srcStride)
+		glc_convertPaletteMatrix((GLfloat*)out, in, format);
+	return 1;
+}
+
+/*	glcUniformMatrixPalette()
+	Returns: 1 (success) or -1 (failure)
+	h - handle of a mat4 array uniform, or of the element to start at
+	src - first source matrix
+	stride - bytes between source matrices, or 0 for tightly packed
+	count - amount of matrices
+	format - layout of the source matrices, a glcPaletteFormat
+	Works in chunks of GLC_PALETTE_CHUNK on the stack; tightly packed 4x4
+	sources go to the driver as they are. */
+int glcUniformMatrixPalette(glcUniformHandle h, const void* src, GLsizei stride, GLsizei count, int format)
+{
+	GLsizei i, chunk, size = glc_paletteSize(format);
+	GLfloat matrices[GLC_PALETTE_CHUNK * 16];
+	const unsigned char* in = (const unsigned char*)src;
+	glcUniformHandle element = h;
+	glcProgramInfo* info;
+
+	if(!size)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Palette format invalid. Got %d.", format);
+		return -1;
+	}
+	if(!stride)
+		stride = size;
+	if(stride == size && format <= GLC_PALETTE_MAT4_ROW_MAJOR)
+	{
+		glcUniformMatrix4fv(h, count, format == GLC_PALETTE_MAT4_ROW_MAJOR ? GL_TRUE : GL_FALSE, (const GLfloat*)src);
+		return 1;
+	}
+	if(!(info = glc_getProgram(h.program)))
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Program %u is not linked.", h.program);
+		return -1;
+	}
+	for(i = 0; i < count; i += chunk)
+	{
+		chunk = (count - i < GLC_PALETTE_CHUNK) ? count - i : GLC_PALETTE_CHUNK;
+		glcConvertMatrixPalette(matrices, 0, in + (size_t)i * stride, stride, chunk, format);
+		glcUniformMatrix4fv(element, chunk, GL_FALSE, matrices);
+		element.location = glc_elementLocation(info, element.location, chunk);
+	}
+	return 1;
+}
+
+/*	glcSetUniformMatrixPalette()
+	Returns: 1 (success) or -1 (failure)
+	program - shader program handle
+	name - name of a mat4 array uniform
+	Remaining parameters are those of glcUniformMatrixPalette. */
+int glcSetUniformMatrixPalette(GLuint program, const char* name, const void* src, GLsizei stride, GLsizei count, int format)
+{
+	glcUniformHandle h = glcGetUniformHandle(program, name);
+
+	if(h.location == -1)
+		return -1;
+	return glcUniformMatrixPalette(h, src, stride, count, format);
+}
+
+/*	Uniform blocks
+	glcGetUniformBlock() reads the layout the linker picked for a uniform
+	block: its size and the offset, array stride and matrix stride of every
+	member. glcPackUniformBlockMember() uses that layout to copy tightly
+	packed CPU-side values into a buffer laid out as the block expects, which
+	handles std140 padding (vec3 and mat3 columns rounded up to vec4, array
+	elements on 16 byte strides) as well as shared layouts. */
+#if defined(GL_VERSION_3_1) || defined(GL_ARB_uniform_buffer_object)
+
+typedef struct glcUniformBlockMember
+{
+	int name;			/* offset into glcUniformBlock::names */
+	GLenum type;
+	GLint size;			/* array size, 1 for non arrays */
+	GLint offset;
+	GLint arrayStride;
+	GLint matrixStride;
+	GLint rowMajor;
+	GLint instanceCount;	/* storage blocks: size of the enclosing top level array, 0 if unsized */
+	GLint instanceStride;	/* storage blocks: stride of the enclosing top level array, else 0 */
+} glcUniformBlockMember;
+
+typedef struct glcUniformBlock
+{
+	GLuint program;
+	GLuint index;
+	GLuint binding;
+	GLint dataSize;
+	int memberCount;
+	glcUniformBlockMember* members;
+	char* names;		/* block name, then member names */
+	GLint runtimeStride;	/* storage blocks: element size of a trailing unsized array, else 0 */
+} glcUniformBlock;
+
+/*	glcFreeUniformBlock()
+	block - uniform block filled by glcGetUniformBlock */
+void glcFreeUniformBlock(glcUniformBlock* block)
+{
+	free(block->members);
+	free(block->names);
+	block->members = NULL;
+	block->names = NULL;
+	block->memberCount = 0;
+}
+
+/*	glcGetUniformBlock()
+	Returns: 1 (success) or -1 (failure)
+	block - pointer to a to be filled uniform block description
+	program - linked shader program handle
+	name - name of the uniform block
+	binding - uniform buffer binding point to assign the block to */
+int glcGetUniformBlock(glcUniformBlock* block, GLuint program, const char* name, GLuint binding)
+{
+	int i, length = (int)strlen(name) + 1;
+	GLint count = 0, maxLength = 0;
+	GLint* values;
+	GLuint* indices;
+
+	memset(block, 0, sizeof(glcUniformBlock));
+	block->program = program;
+	block->binding = binding;
+	block->index = glGetUniformBlockIndex(program, name);
+	if(block->index == GL_INVALID_INDEX)
+	{
+		GLC_LOG(GLC_ERROR_NOT_FOUND, "Uniform block name invalid: %s", name);
+		return -1;
+	}
+	glGetActiveUniformBlockiv(program, block->index, GL_UNIFORM_BLOCK_DATA_SIZE, &block->dataSize);
+	glGetActiveUniformBlockiv(program, block->index, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+	indices = (GLuint*)malloc(count * sizeof(GLuint) + count * sizeof(GLint) + 1);
+	block->members = (glcUniformBlockMember*)calloc(count + 1, sizeof(glcUniformBlockMember));
+	block->names = (char*)malloc((size_t)count * (maxLength + 1) + length);
+	if(!indices || !block->members || !block->names)
+	{
+		GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when querying uniform block.");
+		free(indices);
+		glcFreeUniformBlock(block);
+		return -1;
+	}
+	values = (GLint*)(indices + count);
+	/* the block name goes first in names, members follow */
+	memcpy(block->names, name, length);
+	if(count)
+	{
+		glGetActiveUniformBlockiv(program, block->index, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, (GLint*)indices);
+#define GLC_QUERY_MEMBERS(pname, field) \
+		glGetActiveUniformsiv(program, count, indices, pname, values); \
+		for(i = 0; i < count; i++) \
+			block->members[i].field = values[i];
+		GLC_QUERY_MEMBERS(GL_UNIFORM_TYPE, type)
+		GLC_QUERY_MEMBERS(GL_UNIFORM_SIZE, size)
+		GLC_QUERY_MEMBERS(GL_UNIFORM_OFFSET, offset)
+		GLC_QUERY_MEMBERS(GL_UNIFORM_ARRAY_STRIDE, arrayStride)
+		GLC_QUERY_MEMBERS(GL_UNIFORM_MATRIX_STRIDE, matrixStride)
+		GLC_QUERY_MEMBERS(GL_UNIFORM_IS_ROW_MAJOR, rowMajor)
+#undef GLC_QUERY_MEMBERS
+	}
+	for(i = 0; i < count; i++)
+	{
+		int written = 0;
+		glGetActiveUniformName(program, indices[i], maxLength, &written, block->names + length);
+		block->members[i].name = length;
+		length += written + 1;
+	}
+	free(indices);
+	block->memberCount = count;
+	glUniformBlockBinding(program, block->index, binding);
+	return 1;
+}
+
+/*	glcFindUniformBlockMember()
+	Returns: index of the member in block->members, or -1 if not found
+	block - uniform block filled by glcGetUniformBlock
+	name - member name, as declared or prefixed with the block name.
+		Arrays may be named with or without their [0] suffix. */
+int glcFindUniformBlockMember(const glcUniformBlock* block, const char* name)
+{
+	int i, pass;
+	size_t length = strlen(name), prefix = strlen(block->names);
+
+	for(i = 0; i < block->memberCount; i++)
+	{
+		const char* member = block->names + block->members[i].name;
+		/* members of instanced blocks are reported as "Block.member" */
+		for(pass = 0; pass < 2; pass++)
+		{
+			if(!strncmp(member, name, length) &&
+				(member[length] == '\0' || !strcmp(member + length, "[0]")))
+				return i;
+			if(strncmp(member, block->names, prefix) || member[prefix] != '.')
+				break;
+			member += prefix + 1;
+		}
+	}
+	return -1;
+}
+
+/* Packs count elements of a block member starting at out, its first element.
+   Returns the bytes read from in, or -1 for unsupported types. */
+static int glc_packBlockElements(const glcUniformBlockMember* m, unsigned char* out, const unsigned char* in, int count)
+{
+	int i, c, r, columns, rows, component;
+	const unsigned char* start = in;
+
+	component = glc_typeShape(m->type, &columns, &rows);
+#ifdef GL_ARB_bindless_texture
+	/* any other type in a block is a sampler or image, held as a 64 bit handle */
+	if(!component)
+	{
+		component = 8;
+		columns = rows = 1;
+	}
+#endif
+	if(!component)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Uniform block member type unsupported: 0x%X", m->type);
+		return -1;
+	}
+	for(i = 0; i < count; i++, out += m->arrayStride)
+	{
+		if(columns == 1)
+			memcpy(out, in, rows * component);
+		else if(!m->rowMajor)
+		{
+			for(c = 0; c < columns; c++)
+				memcpy(out + c * m->matrixStride, in + c * rows * component, rows * component);
+		}
+		else
+		{
+			for(c = 0; c < columns; c++)
+				for(r = 0; r < rows; r++)
+					memcpy(out + r * m->matrixStride + c * component, in + (c * rows + r) * component, component);
+		}
+		in += columns * rows * component;
+	}
+	return (int)(in - start);
+}
+
+/*	glcPackUniformBlockMember()
+	Returns: 1 (success) or -1 (failure)
+	block - uniform block filled by glcGetUniformBlock
+	member - index from glcFindUniformBlockMember
+	dst - start of the block's storage, at least block->dataSize bytes
+	src - tightly packed values, matrices column major
+	count - amount of array elements to write, starting at element 0 */
+int glcPackUniformBlockMember(const glcUniformBlock* block, int member, void* dst, const void* src, int count)
+{
+	const glcUniformBlockMember* m;
+
+	if(member < 0 || member >= block->memberCount)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Uniform block member invalid. Got %d.", member);
+		return -1;
+	}
+	m = &block->members[member];
+	if(count < 1 || count > m->size)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Amount invalid. Must be 1-%d. Got %d.", m->size, count);
+		return -1;
+	}
+	return glc_packBlockElements(m, (unsigned char*)dst + m->offset, (const unsigned char*)src, count) == -1 ? -1 : 1;
+}
+
+#endif
+
+/*	Bindless textures
+	With GL_ARB_bindless_texture a texture, or a texture and sampler pair,
+	is referred to by a 64 bit handle that shaders read straight from a
+	sampler uniform or from a uniform or storage block, so materials switch
+	without any glActiveTexture/glBindTexture/glUniform1i traffic.
+	glcGetTextureHandle() fetches the handle and makes it resident, counting
+	references so textures shared by several materials stay resident until
+	the last glcReleaseTextureHandle(). Residency is per context, and so are
+	these references. Note that taking a handle makes the texture and
+	sampler state immutable. Handle uniforms are written at once, also for
+	programs in deferred uniform mode. In blocks, sampler members are packed
+	as 64 bit handles by glcPackUniformBlockMember. */
+#ifdef GL_ARB_bindless_texture
+
+typedef struct glcResidentHandle
+{
+	GLuint64 handle;	/* 0 marks a free slot */
+	int references;
+} glcResidentHandle;
+
+
+static unsigned int glc_hashHandle(GLuint64 handle)
+{
+	handle *= 0x9E3779B97F4A7C15ull;
+	return (unsigned int)(handle >> 32);
+}
+
+static glcResidentHandle* glc_findHandle(glcContext* context, GLuint64 handle)
+{
+	unsigned int i, mask;
+
+	if(!context->residentCapacity)
+		return NULL;
+	mask = (unsigned int)context->residentCapacity - 1;
+	for(i = glc_hashHandle(handle) & mask; context->residentHandles[i].handle; i = (i + 1) & mask)
+	{
+		if(context->residentHandles[i].handle == handle)
+			return &context->residentHandles[i];
+	}
+	return NULL;
+}
+
+static int glc_insertHandle(glcContext* context, GLuint64 handle)
+{
+	unsigned int i, mask;
+
+	if((context->residentCount + 1) * 2 > context->residentCapacity)
+	{
+		int j, capacity = context->residentCapacity ? context->residentCapacity * 2 : 64;
+		glcResidentHandle* table = (glcResidentHandle*)calloc(capacity, sizeof(glcResidentHandle));
+		if(!table)
+			return -1;
+		mask = (unsigned int)capacity - 1;
+		for(j = 0; j < context->residentCapacity; j++)
+		{
+			if(!context->residentHandles[j].handle)
+				continue;
+			for(i = glc_hashHandle(context->residentHandles[j].handle) & mask; table[i].handle; i = (i + 1) & mask);
+			table[i] = context->residentHandles[j];
+		}
+		free(context->residentHandles);
+		context->residentHandles = table;
+		context->residentCapacity = capacity;
+	}
+	mask = (unsigned int)context->residentCapacity - 1;
+	for(i = glc_hashHandle(handle) & mask; context->residentHandles[i].handle; i = (i + 1) & mask);
+	context->residentHandles[i].handle = handle;
+	context->residentHandles[i].references = 1;
+	context->residentCount++;
+	return 1;
+}
+
+/* Backward shift deletion: later entries of the probe run move up into the
+   freed slot, so the residency table never holds tombstones. */
+static void glc_removeHandle(glcContext* context, glcResidentHandle* entry)
+{
+	unsigned int mask = (unsigned int)context->residentCapacity - 1;
+	unsigned int i = (unsigned int)(entry - context->residentHandles), j, home;
+
+	context->residentHandles[i].handle = 0;
+	for(j = (i + 1) & mask; context->residentHandles[j].handle; j = (j + 1) & mask)
+	{
+		home = glc_hashHandle(context->residentHandles[j].handle) & mask;
+		if(((j - home) & mask) >= ((j - i) & mask))
+		{
+			context->residentHandles[i] = context->residentHandles[j];
+			context->residentHandles[j].handle = 0;
+			i = j;
+		}
+	}
+	context->residentCount--;
+}
+
+/*	glcBindlessSupported()
+	Returns: 1 if the context exposes GL_ARB_bindless_texture, else 0 */
+int glcBindlessSupported(void)
+{
+	glcContext* context = glc_getContext();
+
+	if(context->bindless == -1)
+		context->bindless = glc_hasExtension("GL_ARB_bindless_texture");
+	return context->bindless;
+}
+
+/*	glcGetTextureHandle()
+	Returns: 1 (success) or -1 (failure)
+	handle - receives the resident 64 bit handle
+	texture - complete texture object
+	sampler - sampler object to combine with the texture, or 0 to use the
+		texture's own sampling state */
+int glcGetTextureHandle(GLuint64* handle, GLuint texture, GLuint sampler)
+{
+	glcResidentHandle* entry;
+	glcContext* context = glc_getContext();
+
+	*handle = 0;
+	if(!glcBindlessSupported())
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Bindless textures require GL_ARB_bindless_texture.");
+		return -1;
+	}
+	*handle = sampler ? glGetTextureSamplerHandleARB(texture, sampler) : glGetTextureHandleARB(texture);
+	if(!(*handle))
+	{
+		GLC_LOG(GLC_ERROR_GL_OBJECT, "Error creating handle for texture %u.", texture);
+		return -1;
+	}
+	/* the driver hands out the same handle for the same pair */
+	if((entry = glc_findHandle(context, *handle)))
+	{
+		entry->references++;
+		return 1;
+	}
+	if(glc_insertHandle(context, *handle) == -1)
+	{
+		GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when making texture handle resident.");
+		*handle = 0;
+		return -1;
+	}
+	glMakeTextureHandleResidentARB(*handle);
+	return 1;
+}
+
+/*	glcReleaseTextureHandle()
+	handle - handle from glcGetTextureHandle
+	Drops a reference; the last one makes the handle non-resident. The
+	texture must stay alive while any of its handles is resident. */
+void glcReleaseTextureHandle(GLuint64 handle)
+{
+	glcContext* context = glc_getContext();
+	glcResidentHandle* entry = glc_findHandle(context, handle);
+
+	if(!entry || --entry->references > 0)
+		return;
+	glMakeTextureHandleNonResidentARB(handle);
+	glc_removeHandle(context, entry);
+}
+
+/*	glcTextureHandleResident()
+	Returns: references glc holds on the handle, 0 if it is not resident */
+int glcTextureHandleResident(GLuint64 handle)
+{
+	glcResidentHandle* entry = glc_findHandle(glc_getContext(), handle);
+	return entry ? entry->references : 0;
+}
+
+/*	glcUniformHandleui64[v]()
+	h - handle of a sampler uniform
+	Remaining parameters are those of glUniformHandleui64[v]ARB. */
+void glcUniformHandleui64(glcUniformHandle h, GLuint64 value)
+{
+	GLC_UNIFORM_CALL(Handleui64ARB, value);
+}
+
+void glcUniformHandleui64v(glcUniformHandle h, GLsizei count, const GLuint64* values)
+{
+	GLC_UNIFORM_CALL(Handleui64vARB, count, values);
+}
+
+/*	glcSetUniformHandleui64()
+	Returns: 1 (success) or -1 (failure)
+	program - shader program handle
+	name - name of a sampler uniform
+	value - resident texture handle */
+int glcSetUniformHandleui64(GLuint program, const char* name, GLuint64 value)
+{
+	glcUniformHandle h = glcGetUniformHandle(program, name);
+
+	if(h.location == -1)
+		return -1;
+	glcUniformHandleui64(h, value);
+	return 1;
+}
+
+#endif
+
+/*	Uniform buffer ring
+	A persistently mapped uniform buffer split into GLC_RING_FRAMES regions,
+	one per frame in flight. Each frame writes its block data into the next
+	region and binds it with glBindBufferRange. A fence placed at the end of
+	the frame guards the region until the GPU is done reading it, so writes
+	never stall on the driver and nothing is reallocated. */
+#if defined(GL_VERSION_4_4) || defined(GL_ARB_buffer_storage)
+
+#define GLC_RING_FRAMES 3
+
+typedef struct glcUniformRing
+{
+	GLuint buffer;
+	GLsizeiptr frameSize;
+	GLint alignment;
+	int frame;
+	GLintptr head;
+	unsigned char* data;
+	GLsync fences[GLC_RING_FRAMES];
+} glcUniformRing;
+
+/*	glcMakeUniformRing()
+	Returns: 1 (success) or -1 (failure)
+	ring - pointer to a to be uniform ring
+	frameSize - bytes of block data written per frame */
+int glcMakeUniformRing(glcUniformRing* ring, GLsizeiptr frameSize)
+{
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	memset(ring, 0, sizeof(glcUniformRing));
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ring->alignment);
+	if(ring->alignment < 1)
+		ring->alignment = 256;
+	ring->frameSize = (frameSize + ring->alignment - 1) / ring->alignment * ring->alignment;
+	glGenBuffers(1, &ring->buffer);
+	if(!ring->buffer)
+	{
+		GLC_LOG(GLC_ERROR_GL_OBJECT, "Error creating uniform buffer object.");
+		return -1;
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, ring->buffer);
+	glBufferStorage(GL_UNIFORM_BUFFER, ring->frameSize * GLC_RING_FRAMES, NULL, flags);
+	ring->data = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, ring->frameSize * GLC_RING_FRAMES, flags);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	if(!ring->data)
+	{
+		GLC_LOG(GLC_ERROR_GL_OBJECT, "Error mapping uniform buffer object.");
+		glDeleteBuffers(1, &ring->buffer);
+		ring->buffer = 0;
+		return -1;
+	}
+	return 1;
+}
+
+/*	glcDeleteUniformRing()
+	ring - uniform ring made by glcMakeUniformRing */
+void glcDeleteUniformRing(glcUniformRing* ring)
+{
+	int i;
+
+	for(i = 0; i < GLC_RING_FRAMES; i++)
+	{
+		if(ring->fences[i])
+			glDeleteSync(ring->fences[i]);
+		ring->fences[i] = NULL;
+	}
+	if(ring->buffer)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, ring->buffer);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glDeleteBuffers(1, &ring->buffer);
+	}
+	ring->buffer = 0;
+	ring->data = NULL;
+}
+
+/*	glcBeginUniformRingFrame()
+	ring - uniform ring made by glcMakeUniformRing
+	Moves on to the next region, waiting only if the GPU is still reading it
+	from GLC_RING_FRAMES frames ago. */
+void glcBeginUniformRingFrame(glcUniformRing* ring)
+{
+	GLsync fence = ring->fences[ring->frame];
+
+	if(fence)
+	{
+		while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(fence);
+		ring->fences[ring->frame] = NULL;
+	}
+	ring->head = 0;
+}
+
+/*	glcAllocUniformRing()
+	Returns: pointer to write the block data to, or NULL if the frame is full
+	ring - uniform ring made by glcMakeUniformRing
+	size - bytes to allocate, usually glcUniformBlock::dataSize
+	offset - receives the offset to pass to glcBindUniformRing */
+void* glcAllocUniformRing(glcUniformRing* ring, GLsizeiptr size, GLintptr* offset)
+{
+	GLintptr start = ring->frame * ring->frameSize + ring->head;
+
+	if(ring->head + size > ring->frameSize)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Uniform ring frame full. Frame size is %ld bytes.", (long)ring->frameSize);
+		return NULL;
+	}
+	ring->head += (size + ring->alignment - 1) / ring->alignment * ring->alignment;
+	*offset = start;
+	return ring->data + start;
+}
+
+/*	glcBindUniformRing()
+	ring - uniform ring made by glcMakeUniformRing
+	binding - uniform buffer binding point of the block
+	offset - offset returned by glcAllocUniformRing
+	size - bytes to bind */
+void glcBindUniformRing(const glcUniformRing* ring, GLuint binding, GLintptr offset, GLsizeiptr size)
+{
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, ring->buffer, offset, size);
+}
+
+/*	glcEndUniformRingFrame()
+	ring - uniform ring made by glcMakeUniformRing
+	Call after the last draw reading this frame's region has been issued. */
+void glcEndUniformRingFrame(glcUniformRing* ring)
+{
+	ring->fences[ring->frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	ring->frame = (ring->frame + 1) % GLC_RING_FRAMES;
+}
+
+#endif
+
+/*	Streaming buffer
+	A persistently mapped ring for dynamic vertex, index or any other per
+	draw data, replacing glBufferData orphaning. Allocations are carved out
+	one after another and wrap around at the end. glcFenceStreamBuffer()
+	puts a fence behind everything allocated since the previous fence, and
+	space is reclaimed as those fences signal, so an allocation only waits
+	when the GPU still reads the whole ring. Size it for a few frames of
+	data to never wait.
+	The buffer has no fixed target: bind stream->buffer as GL_ARRAY_BUFFER
+	or with glBindVertexBuffer at the returned offset for vertices, and as
+	GL_ELEMENT_ARRAY_BUFFER with the offset as indices pointer for indices. */
+#if defined(GL_VERSION_4_4) || defined(GL_ARB_buffer_storage)
+
+#define GLC_STREAM_FENCES 16
+
+typedef struct glcStreamFence
+{
+	GLsync sync;
+	unsigned long long end;		/* stream position the fence covers up to */
+} glcStreamFence;
+
+typedef struct glcStreamBuffer
+{
+	GLuint buffer;
+	GLsizeiptr size;
+	unsigned char* data;
+	/* positions run on past size and are wrapped when used */
+	unsigned long long head;	/* next free byte */
+	unsigned long long tail;	/* oldest byte the GPU may still read */
+	unsigned long long fenced;	/* end of the fenced allocations */
+	int fenceHead;				/* oldest fence */
+	int fenceCount;
+	glcStreamFence fences[GLC_STREAM_FENCES];
+} glcStreamBuffer;
+
+/*	glcMakeStreamBuffer()
+	Returns: 1 (success) or -1 (failure)
+	stream - pointer to a to be streaming buffer
+	size - capacity in bytes */
+int glcMakeStreamBuffer(glcStreamBuffer* stream, GLsizeiptr size)
+{
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	memset(stream, 0, sizeof(glcStreamBuffer));
+	if(size < 1)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Stream buffer size invalid. Got %ld.", (long)size);
+		return -1;
+	}
+	glGenBuffers(1, &stream->buffer);
+	if(!stream->buffer)
+	{
+		GLC_LOG(GLC_ERROR_GL_OBJECT, "Error creating stream buffer object.");
+		return -1;
+	}
+	/* a target no vertex array object records */
+	glBindBuffer(GL_COPY_WRITE_BUFFER, stream->buffer);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, size, NULL, flags);
+	stream->data = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	if(!stream->data)
+	{
+		GLC_LOG(GLC_ERROR_GL_OBJECT, "Error mapping stream buffer object.");
+		glDeleteBuffers(1, &stream->buffer);
+		stream->buffer = 0;
+		return -1;
+	}
+	stream->size = size;
+	return 1;
+}
+
+/*	glcDeleteStreamBuffer()
+	stream - streaming buffer made by glcMakeStreamBuffer */
+void glcDeleteStreamBuffer(glcStreamBuffer* stream)
+{
+	int i;
+
+	for(i = 0; i < stream->fenceCount; i++)
+		glDeleteSync(stream->fences[(stream->fenceHead + i) % GLC_STREAM_FENCES].sync);
+	if(stream->buffer)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, stream->buffer);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glDeleteBuffers(1, &stream->buffer);
+	}
+	memset(stream, 0, sizeof(glcStreamBuffer));
+}
+
+/* Retires the oldest fence, waiting for it only if wait is set. Returns 1
+   if it was retired. */
+static int glc_retireStreamFence(glcStreamBuffer* stream, int wait)
+{
+	GLenum status;
+	glcStreamFence* fence = &stream->fences[stream->fenceHead];
+
+	if(!stream->fenceCount)
+		return 0;
+	status = glClientWaitSync(fence->sync, 0, 0);
+	if(status == GL_TIMEOUT_EXPIRED)
+	{
+		if(!wait)
+			return 0;
+		GLC_STAT(frame.bufferWaits++);
+		while((status = glClientWaitSync(fence->sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000)) == GL_TIMEOUT_EXPIRED);
+	}
+	glDeleteSync(fence->sync);
+	stream->tail = fence->end;
+	stream->fenceHead = (stream->fenceHead + 1) % GLC_STREAM_FENCES;
+	stream->fenceCount--;
+	return 1;
+}
+
+/*	glcFenceStreamBuffer()
+	stream - streaming buffer made by glcMakeStreamBuffer
+	Call after issuing the draws that read the data allocated so far, for
+	example once per frame. */
+void glcFenceStreamBuffer(glcStreamBuffer* stream)
+{
+	glcStreamFence* fence;
+
+	if(stream->fenced == stream->head)
+		return;
+	if(stream->fenceCount == GLC_STREAM_FENCES)
+		glc_retireStreamFence(stream, 1);
+	fence = &stream->fences[(stream->fenceHead + stream->fenceCount) % GLC_STREAM_FENCES];
+	fence->sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	fence->end = stream->head;
+	stream->fenceCount++;
+	stream->fenced = stream->head;
+}
+
+/*	glcAllocStreamBuffer()
+	Returns: pointer to write the data to, or NULL on failure
+	stream - streaming buffer made by glcMakeStreamBuffer
+	size - bytes to allocate
+	alignment - alignment of the offset, such as the vertex stride or the
+		index size, or 0 for 16 bytes
+	offset - receives the offset of the allocation in stream->buffer */
+void* glcAllocStreamBuffer(glcStreamBuffer* stream, GLsizeiptr size, GLsizeiptr alignment, GLintptr* offset)
+{
+	unsigned long long start, position, aligned, capacity = (unsigned long long)stream->size;
+
+	if(size < 1 || size > stream->size || alignment < 0)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Stream allocation invalid. Must be 1-%ld bytes. Got %ld.", (long)stream->size, (long)size);
+		return NULL;
+	}
+	if(!alignment)
+		alignment = 16;
+	position = stream->head % capacity;
+	aligned = (position + alignment - 1) / alignment * alignment;
+	/* an allocation never straddles the end, it restarts at offset 0 */
+	start = stream->head - position + ((aligned + size > capacity) ? capacity : aligned);
+	if(start + size - stream->tail > capacity)
+	{
+		/* what is free without waiting first, then the oldest fences */
+		while(start + size - stream->tail > capacity && glc_retireStreamFence(stream, 0));
+		if(start + size - stream->tail > capacity && stream->fenced != stream->head)
+			glcFenceStreamBuffer(stream);
+		while(start + size - stream->tail > capacity && glc_retireStreamFence(stream, 1));
+	}
+	stream->head = start + size;
+	*offset = (GLintptr)(start % capacity);
+	return stream->data + *offset;
+}
+
+#endif
+
+/*	Storage blocks
+	Shader storage blocks hold per-instance data of any size, where uniform
+	arrays stop at GL_MAX_UNIFORM_COMPONENTS and force draws to be split.
+	glcGetStorageBlock() reads a block's layout through the program interface
+	queries into a glcUniformBlock, so glcFindUniformBlockMember() and
+	glcFreeUniformBlock() work on it too. A block usually ends in an unsized
+	array with one element per instance, such as
+		buffer Instances { mat4 models[]; };
+		buffer Instances { Instance instances[]; };
+	and glcPackStorageBlockMember() writes any range of those elements.
+	glcStreamStorageBlock() carves a block for a given element count out of
+	a glcStreamBuffer and binds it, ready for a single instanced draw. */
+#if defined(GL_VERSION_4_3) || defined(GL_ARB_shader_storage_buffer_object)
+
+/*	glcGetStorageBlock()
+	Returns: 1 (success) or -1 (failure)
+	block - pointer to a to be filled block description
+	program - linked shader program handle
+	name - name of the shader storage block
+	binding - shader storage buffer binding point to assign the block to */
+int glcGetStorageBlock(glcUniformBlock* block, GLuint program, const char* name, GLuint binding)
+{
+	int i, length = (int)strlen(name) + 1;
+	GLint count = 0, maxLength = 0, values[9];
+	GLint* indices;
+	const GLenum blockProperties[2] = { GL_BUFFER_DATA_SIZE, GL_NUM_ACTIVE_VARIABLES };
+	const GLenum activeVariables = GL_ACTIVE_VARIABLES;
+	const GLenum properties[9] = { GL_TYPE, GL_ARRAY_SIZE, GL_OFFSET, GL_ARRAY_STRIDE, GL_MATRIX_STRIDE,
+		GL_IS_ROW_MAJOR, GL_TOP_LEVEL_ARRAY_SIZE, GL_TOP_LEVEL_ARRAY_STRIDE, GL_NAME_LENGTH };
+
+	memset(block, 0, sizeof(glcUniformBlock));
+	block->program = program;
+	block->binding = binding;
+	block->index = glGetProgramResourceIndex(program, GL_SHADER_STORAGE_BLOCK, name);
+	if(block->index == GL_INVALID_INDEX)
+	{
+		GLC_LOG(GLC_ERROR_NOT_FOUND, "Storage block name invalid: %s", name);
+		return -1;
+	}
+	glGetProgramResourceiv(program, GL_SHADER_STORAGE_BLOCK, block->index, 2, blockProperties, 2, NULL, values);
+	block->dataSize = values[0];
+	count = values[1];
+	glGetProgramInterfaceiv(program, GL_BUFFER_VARIABLE, GL_MAX_NAME_LENGTH, &maxLength);
+
+	indices = (GLint*)malloc(count * sizeof(GLint) + 1);
+	block->members = (glcUniformBlockMember*)calloc(count + 1, sizeof(glcUniformBlockMember));
+	block->names = (char*)malloc((size_t)count * (maxLength + 1) + length);
+	if(!indices || !block->members || !block->names)
+	{
+		GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when querying storage block.");
+		free(indices);
+		glcFreeUniformBlock(block);
+		return -1;
+	}
+	memcpy(block->names, name, length);
+	if(count)
+		glGetProgramResourceiv(program, GL_SHADER_STORAGE_BLOCK, block->index, 1, &activeVariables, count, NULL, indices);
+	for(i = 0; i < count; i++)
+	{
+		int written = 0;
+		glcUniformBlockMember* m = &block->members[i];
+		glGetProgramResourceiv(program, GL_BUFFER_VARIABLE, indices[i], 9, properties, 9, NULL, values);
+		m->type = values[0];
+		m->size = values[1];
+		m->offset = values[2];
+		m->arrayStride = values[3];
+		m->matrixStride = values[4];
+		m->rowMajor = values[5];
+		m->instanceCount = values[6];
+		m->instanceStride = values[7];
+		/* an unsized array is either the member itself or the struct array around it */
+		if(!m->size)
+			block->runtimeStride = m->arrayStride;
+		else if(!m->instanceCount && m->instanceStride)
+			block->runtimeStride = m->instanceStride;
+		glGetProgramResourceName(program, GL_BUFFER_VARIABLE, indices[i], maxLength, &written, block->names + length);
+		m->name = length;
+		length += written + 1;
+	}
+	free(indices);
+	block->memberCount = count;
+	glShaderStorageBlockBinding(program, block->index, binding);
+	return 1;
+}
+
+/*	glcStorageBlockSize()
+	Returns: bytes the block takes with count elements in its trailing
+	unsized array, or its fixed size if it has none
+	block - storage block filled by glcGetStorageBlock
+	count - amount of array elements */
+GLsizeiptr glcStorageBlockSize(const glcUniformBlock* block, GLsizei count)
+{
+	/* the reported size already holds one element */
+	return (GLsizeiptr)block->dataSize + (GLsizeiptr)(count > 1 ? count - 1 : 0) * block->runtimeStride;
+}
+
+/*	glcPackStorageBlockMember()
+	Returns: 1 (success) or -1 (failure)
+	block - storage block filled by glcGetStorageBlock
+	member - index from glcFindUniformBlockMember
+	dst - start of the block's storage, at least glcStorageBlockSize bytes
+	first - first element to write
+	src - tightly packed values, matrices column major
+	count - amount of elements to write. For members of a struct array,
+		such as instances[0].model, these are elements of the struct array
+		and src holds every array element of the member for each of them;
+		otherwise elements of the member itself. */
+int glcPackStorageBlockMember(const glcUniformBlock* block, int member, void* dst, GLsizei first, const void* src, GLsizei count)
+{
+	int i, read;
+	GLsizei limit;
+	const glcUniformBlockMember* m;
+	unsigned char* out;
+	const unsigned char* in = (const unsigned char*)src;
+
+	if(member < 0 || member >= block->memberCount)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Storage block member invalid. Got %d.", member);
+		return -1;
+	}
+	m = &block->members[member];
+	limit = m->instanceStride ? m->instanceCount : m->size;
+	if(first < 0 || count < 1 || (limit && (first > limit || count > limit - first)))
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Element range invalid. Must be within 0-%d. Got %d-%d.", limit, first, first + count);
+		return -1;
+	}
+	out = (unsigned char*)dst + m->offset;
+	if(!m->instanceStride)
+		return glc_packBlockElements(m, out + (size_t)first * m->arrayStride, in, count) == -1 ? -1 : 1;
+	out += (size_t)first * m->instanceStride;
+	for(i = 0; i < count; i++, out += m->instanceStride, in += read)
+	{
+		if((read = glc_packBlockElements(m, out, in, m->size)) == -1)
+			return -1;
+	}
+	return 1;
+}
+
+/*	glcBindStorageBlock()
+	block - storage block filled by glcGetStorageBlock
+	buffer - buffer object holding the block
+	offset - start of the block in the buffer, a multiple of
+		GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+	size - bytes of the block, or 0 to bind the whole buffer */
+void glcBindStorageBlock(const glcUniformBlock* block, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	if(size)
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, block->binding, buffer, offset, size);
+	else
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, block->binding, buffer);
+}
+
+#if defined(GL_VERSION_4_4) || defined(GL_ARB_buffer_storage)
+
+/*	glcStreamStorageBlock()
+	Returns: pointer to the block's storage to fill, e.g. with
+	glcPackStorageBlockMember, or NULL on failure
+	block - storage block filled by glcGetStorageBlock
+	stream - streaming buffer made by glcMakeStreamBuffer
+	count - amount of elements in the block's trailing unsized array
+	Allocates glcStorageBlockSize(block, count) bytes from the stream and
+	binds them to the block's binding point. Fence the stream after the
+	draws that read it, as for any other allocation. */
+void* glcStreamStorageBlock(const glcUniformBlock* block, glcStreamBuffer* stream, GLsizei count)
+{
+	void* data;
+	GLintptr offset;
+	GLsizeiptr size = glcStorageBlockSize(block, count);
+	glcContext* context = glc_getContext();
+
+	if(!context->storageAlignment)
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &context->storageAlignment);
+	if(!(data = glcAllocStreamBuffer(stream, size, context->storageAlignment, &offset)))
+		return NULL;
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, block->binding, stream->buffer, offset, size);
+	return data;
+}
+
+#endif
+
+#endif
+
+/*	Vertex arrays
+	A glcVertexLayout describes where each vertex attribute sits in a set of
+	vertex buffers. glcGetVertexArray() matches it by name against the active
+	inputs of a linked program and returns a vertex array object holding only
+	the format: every input gets its location, type and buffer binding
+	through glVertexAttribFormat and glVertexAttribBinding, with integer and
+	double inputs taking the I and L variants and matrix and array inputs
+	spanning their consecutive locations. Attributes the program does not
+	read are ignored, while an active input missing from the layout is an
+	error. Vertex arrays are cached by the resolved format, so programs with
+	the same inputs at the same locations share one and any meshes with the
+	same layout do too; switching meshes only needs
+	glcBindVertexBuffers() to swap the buffers. Look vertex arrays up once
+	per layout and program and keep them. Like pipelines, they belong to
+	the current glcContext and are deleted by glcDeleteContext. */
+#if defined(GL_VERSION_4_3) || defined(GL_ARB_vertex_attrib_binding)
+
+#define GLC_MAX_VERTEX_ATTRIBS 16	/* locations a vertex array sets up */
+#define GLC_MAX_VERTEX_BINDINGS 8
+
+enum
+{
+	GLC_ATTRIB_FLOAT, GLC_ATTRIB_INTEGER, GLC_ATTRIB_DOUBLE
+};
+
+typedef struct glcVertexAttrib
+{
+	const char* name;		/* shader input, arrays without their [0] suffix */
+	GLuint binding;			/* vertex buffer binding, below the layout's bindingCount */
+	GLint size;				/* components, 1-4 or GL_BGRA */
+	GLenum type;			/* GL_FLOAT, GL_UNSIGNED_BYTE, GL_INT_2_10_10_10_REV, ... */
+	GLboolean normalized;	/* fixed point values read by float inputs */
+	GLuint offset;			/* bytes from the start of a vertex */
+} glcVertexAttrib;
+
+typedef struct glcVertexLayout
+{
+	int attribCount;
+	glcVertexAttrib attribs[GLC_MAX_VERTEX_ATTRIBS];
+	int bindingCount;
+	GLsizei strides[GLC_MAX_VERTEX_BINDINGS];	/* bytes between vertices of each binding */
+	GLuint divisors[GLC_MAX_VERTEX_BINDINGS];	/* 0 per vertex, n per n instances */
+} glcVertexLayout;
+
+/* One enabled location, compared and hashed as raw bytes. */
+typedef struct glcVertexFormat
+{
+	GLuint location;
+	GLuint binding;
+	GLuint offset;
+	GLenum type;
+	GLint size;
+	GLint normalized;
+	GLint kind;				/* GLC_ATTRIB_* */
+} glcVertexFormat;
+
+typedef struct glcVertexArray
+{
+	unsigned long long key;		/* 0 marks a free slot */
+	GLuint vertexArray;
+	int formatCount;
+	int bindingCount;
+	glcVertexFormat formats[GLC_MAX_VERTEX_ATTRIBS];	/* sorted by location */
+	GLuint divisors[GLC_MAX_VERTEX_BINDINGS];
+} glcVertexArray;
+
+static int glc_attribKind(GLenum type)
+{
+	switch(type)
+	{
+	case GL_INT: case GL_INT_VEC2: case GL_INT_VEC3: case GL_INT_VEC4:
+	case GL_UNSIGNED_INT: case GL_UNSIGNED_INT_VEC2: case GL_UNSIGNED_INT_VEC3: case GL_UNSIGNED_INT_VEC4:
+		return GLC_ATTRIB_INTEGER;
+	case GL_DOUBLE: case GL_DOUBLE_VEC2: case GL_DOUBLE_VEC3: case GL_DOUBLE_VEC4:
+	case GL_DOUBLE_MAT2: case GL_DOUBLE_MAT3: case GL_DOUBLE_MAT4:
+	case GL_DOUBLE_MAT2x3: case GL_DOUBLE_MAT2x4: case GL_DOUBLE_MAT3x2:
+	case GL_DOUBLE_MAT3x4: case GL_DOUBLE_MAT4x2: case GL_DOUBLE_MAT4x3:
+		return GLC_ATTRIB_DOUBLE;
+	default:
+		return GLC_ATTRIB_FLOAT;
+	}
+}
+
+/* Returns the bytes one location of an attribute reads, 0 for unknown types. */
+static GLuint glc_attribBytes(GLint size, GLenum type)
+{
+	if(size == GL_BGRA)
+		size = 4;
+	switch(type)
+	{
+	case GL_BYTE: case GL_UNSIGNED_BYTE:	return (GLuint)size;
+	case GL_SHORT: case GL_UNSIGNED_SHORT:
+	case GL_HALF_FLOAT:						return (GLuint)size * 2;
+	case GL_INT: case GL_UNSIGNED_INT:
+	case GL_FLOAT: case GL_FIXED:			return (GLuint)size * 4;
+	case GL_DOUBLE:							return (GLuint)size * 8;
+	case GL_INT_2_10_10_10_REV:
+	case GL_UNSIGNED_INT_2_10_10_10_REV:
+	case GL_UNSIGNED_INT_10F_11F_11F_REV:	return 4;
+	default:								return 0;
+	}
+}
+
+static const glcVertexAttrib* glc_findAttrib(const glcVertexLayout* layout, const char* input)
+{
+	int i;
+	size_t length;
+
+	for(i = 0; i < layout->attribCount; i++)
+	{
+		length = strlen(layout->attribs[i].name);
+		if(!strncmp(input, layout->attribs[i].name, length) && (input[length] == '\0' || !strcmp(input + length, "[0]")))
+			return &layout->attribs[i];
+	}
+	return NULL;
+}
+
+/* Fills formats with every location the program's inputs take, sorted by
+   location. Returns the amount, or -1 on failure. */
+static int glc_resolveVertexFormats(glcVertexFormat* formats, const glcVertexLayout* layout, const glcProgramInfo* info)
+{
+	int i, j, count = 0, columns, rows, slots, span;
+	GLuint bytes;
+	glcVertexFormat format;
+	const glcVertexAttrib* a;
+	const glcProgramResource* r;
+
+	for(i = 0, r = info->resources; i < info->resourceCount; i++, r++)
+	{
+		/* built-ins such as gl_VertexID have no location */
+		if(r->interface != GLC_RESOURCE_INPUT || r->location == -1)
+			continue;
+		if(!(a = glc_findAttrib(layout, r->name)))
+		{
+			GLC_LOG(GLC_ERROR_NOT_FOUND, "Vertex layout has no attribute for input %s of program %u.", r->name, info->program);
+			return -1;
+		}
+		if(a->binding >= (GLuint)layout->bindingCount || !(bytes = glc_attribBytes(a->size, a->type)))
+		{
+			GLC_LOG(GLC_ERROR_INVALID_VALUE, "Vertex attribute %s invalid. Got binding %u, size %d, type 0x%x.", a->name, a->binding, a->size, a->type);
+			return -1;
+		}
+		memset(&format, 0, sizeof(format));
+		format.binding = a->binding;
+		format.type = a->type;
+		format.size = a->size;
+		format.normalized = a->normalized;
+		format.kind = glc_attribKind(r->type);
+		/* a matrix takes a location per column, a dvec3 or dvec4 column two */
+		if(!glc_typeShape(r->type, &columns, &rows))
+			columns = rows = 1;
+		span = (format.kind == GLC_ATTRIB_DOUBLE && rows > 2) ? 2 : 1;
+		slots = columns * (r->size > 1 ? r->size : 1);
+		for(j = 0; j < slots; j++)
+		{
+			if(count == GLC_MAX_VERTEX_ATTRIBS)
+			{
+				GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Program %u takes more than %d vertex attribute locations.", info->program, GLC_MAX_VERTEX_ATTRIBS);
+				return -1;
+			}
+			format.location = (GLuint)(r->location + j * span);
+			format.offset = a->offset + (GLuint)j * bytes;
+			formats[count++] = format;
+		}
+	}
+	/* insertion sort, so the order the program lists its inputs in does not matter */
+	for(i = 1; i < count; i++)
+	{
+		format = formats[i];
+		for(j = i; j > 0 && formats[j - 1].location > format.location; j--)
+			formats[j] = formats[j - 1];
+		formats[j] = format;
+	}
+	return count;
+}
+
+static int glc_growVertexArrays(glcContext* context)
+{
+	int i, capacity = context->vertexArrayCapacity ? context->vertexArrayCapacity * 2 : 32;
+	unsigned int j, mask = (unsigned int)capacity - 1;
+	glcVertexArray* table = (glcVertexArray*)calloc(capacity, sizeof(glcVertexArray));
+
+	if(!table)
+		return -1;
+	for(i = 0; i < context->vertexArrayCapacity; i++)
+	{
+		if(!context->vertexArrays[i].key)
+			continue;
+		for(j = (unsigned int)context->vertexArrays[i].key & mask; table[j].key; j = (j + 1) & mask);
+		table[j] = context->vertexArrays[i];
+	}
+	free(context->vertexArrays);
+	context->vertexArrays = table;
+	context->vertexArrayCapacity = capacity;
+	return 1;
+}
+
+/*	glcGetVertexArray()
+	Returns: 1 (success) or -1 (failure)
+	vertexArray - receives the vertex array object handle, owned by glc
+	layout - where the attributes sit in the vertex buffers
+	program - linked shader program handle the vertex array is for
+	The first call for a format creates the vertex array, later calls return
+	it from the cache. Either call leaves it bound. */
+int glcGetVertexArray(GLuint* vertexArray, const glcVertexLayout* layout, GLuint program)
+{
+	int i, count;
+	unsigned int j, mask;
+	unsigned long long key;
+	glcVertexFormat formats[GLC_MAX_VERTEX_ATTRIBS];
+	const glcVertexFormat* f;
+	glcProgramInfo* info;
+	glcVertexArray* entry;
+	glcContext* context = glc_getContext();
+
+	if(layout->attribCount < 0 || layout->attribCount > GLC_MAX_VERTEX_ATTRIBS || layout->bindingCount < 1 || layout->bindingCount > GLC_MAX_VERTEX_BINDINGS)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Vertex layout invalid. Must have 0-%d attributes and 1-%d bindings. Got %d and %d.",
+			GLC_MAX_VERTEX_ATTRIBS, GLC_MAX_VERTEX_BINDINGS, layout->attribCount, layout->bindingCount);
+		return -1;
+	}
+	/* also finishes a program that is still building */
+	if(!(info = glc_getProgram(program)))
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Program %u is not linked.", program);
+		return -1;
+	}
+	if((count = glc_resolveVertexFormats(formats, layout, info)) == -1)
+		return -1;
+	key = glc_hashBytes(14695981039346656037ull, formats, count * sizeof(glcVertexFormat));
+	key = glc_hashBytes(key, layout->divisors, layout->bindingCount * sizeof(GLuint));
+	key = key ? key : 1;
+	if(context->vertexArrayCapacity)
+	{
+		mask = (unsigned int)context->vertexArrayCapacity - 1;
+		for(j = (unsigned int)key & mask; context->vertexArrays[j].key; j = (j + 1) & mask)
+		{
+			entry = &context->vertexArrays[j];
+			if(entry->key == key && entry->formatCount == count && entry->bindingCount == layout->bindingCount &&
+				!memcmp(entry->formats, formats, count * sizeof(glcVertexFormat)) &&
+				!memcmp(entry->divisors, layout->divisors, layout->bindingCount * sizeof(GLuint)))
+			{
+				*vertexArray = entry->vertexArray;
+				glcBindVertexArray(*vertexArray);
+				return 1;
+			}
+		}
+	}
+	if((context->vertexArrayCount + 1) * 2 > context->vertexArrayCapacity && glc_growVertexArrays(context) == -1)
+	{
+		GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when creating vertex array.");
+		return -1;
+	}
+	*vertexArray = 0;
+	glGenVertexArrays(1, vertexArray);
+	if(!(*vertexArray))
+	{
+		GLC_LOG(GLC_ERROR_GL_OBJECT, "Error creating vertex array object.");
+		return -1;
+	}
+	glcBindVertexArray(*vertexArray);
+	for(i = 0, f = formats; i < count; i++, f++)
+	{
+		glEnableVertexAttribArray(f->location);
+		if(f->kind == GLC_ATTRIB_INTEGER)
+			glVertexAttribIFormat(f->location, f->size, f->type, f->offset);
+		else if(f->kind == GLC_ATTRIB_DOUBLE)
+			glVertexAttribLFormat(f->location, f->size, f->type, f->offset);
+		else
+			glVertexAttribFormat(f->location, f->size, f->type, (GLboolean)f->normalized, f->offset);
+		glVertexAttribBinding(f->location, f->binding);
+	}
+	for(i = 0; i < layout->bindingCount; i++)
+		glVertexBindingDivisor((GLuint)i, layout->divisors[i]);
+	mask = (unsigned int)context->vertexArrayCapacity - 1;
+	for(j = (unsigned int)key & mask; context->vertexArrays[j].key; j = (j + 1) & mask);
+	entry = &context->vertexArrays[j];
+	entry->key = key;
+	entry->vertexArray = *vertexArray;
+	entry->formatCount = count;
+	entry->bindingCount = layout->bindingCount;
+	memcpy(entry->formats, formats, count * sizeof(glcVertexFormat));
+	memcpy(entry->divisors, layout->divisors, layout->bindingCount * sizeof(GLuint));
+	context->vertexArrayCount++;
+	return 1;
+}
+
+/*	glcBindVertexBuffers()
+	layout - the layout the vertex array was made for
+	vertexArray - vertex array object from glcGetVertexArray
+	buffers - one vertex buffer per binding of the layout
+	offsets - start of the first vertex in each buffer, or NULL for 0
+	indexBuffer - element buffer for indexed draws, or 0 for none
+	Binds the vertex array and attaches a mesh's buffers to it with the
+	layout's strides; the attribute formats stay as they are. */
+void glcBindVertexBuffers(const glcVertexLayout* layout, GLuint vertexArray, const GLuint* buffers, const GLintptr* offsets, GLuint indexBuffer)
+{
+	int i;
+
+	glcBindVertexArray(vertexArray);
+	for(i = 0; i < layout->bindingCount; i++)
+		glBindVertexBuffer((GLuint)i, buffers[i], offsets ? offsets[i] : 0, layout->strides[i]);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+}
+
+#endif
+
+/*	Indirect draws
+	A glcDrawList gathers a frame's draws as GL indirect commands in a
+	glcStreamBuffer, so tens of thousands of objects go out in a single
+	glMultiDrawElementsIndirect instead of a draw and a round of uniform sets
+	each. glcBeginDrawList() carves room for the commands and, given a
+	storage block from glcGetStorageBlock, for the per-instance data the
+	draws read in place of uniforms. glcAddDrawElements() appends a draw and
+	returns where its instances start in that data, which is also its base
+	instance: pack its elements there with glcPackStorageBlockMember() and
+	index the block in the vertex shader with
+		gl_BaseInstanceARB + gl_InstanceID		(GL 4.6 or ARB_shader_draw_parameters)
+	or, without shader draw parameters, with an instanced uint attribute
+	(divisor 1) reading 0, 1, 2, ..., which the base instance offsets the
+	same way. The base instance keeps working once culling has dropped or
+	reordered draws, gl_DrawID does not.
+	With GLC_DRAW_LIST_CULL every draw also takes a bounding sphere, and
+	glcCullDrawList() has a compute shader, built once through the program
+	builder, test the spheres against the frustum planes and write the draw
+	list on the GPU. Where glMultiDrawElementsIndirectCount is available
+	(GL 4.6 or ARB_indirect_parameters) the visible draws are packed
+	together and counted, in no particular order; elsewhere culled draws
+	keep their place with an instance count of 0. During the dispatch the
+	four storage buffer bindings from GLC_CULL_BINDING on are overwritten;
+	define GLC_CULL_BINDING before including glc.h to move them. The bound
+	program is restored afterwards.
+	Fence the stream after the draws as for any other allocation. */
+#if (defined(GL_VERSION_4_3) || defined(GL_ARB_multi_draw_indirect)) && (defined(GL_VERSION_4_4) || defined(GL_ARB_buffer_storage))
+
+#define GLC_DRAW_LIST_CULL 1	/* glcBeginDrawList flag */
+#ifndef GLC_CULL_BINDING
+#define GLC_CULL_BINDING 0		/* first storage buffer binding glcCullDrawList uses */
+#endif
+
+#if defined(GL_VERSION_4_6)
+#define GLC_INDIRECT_COUNT
+#define GLC_PARAMETER_BUFFER GL_PARAMETER_BUFFER
+#define glc_multiDrawElementsIndirectCount glMultiDrawElementsIndirectCount
+#elif defined(GL_ARB_indirect_parameters)
+#define GLC_INDIRECT_COUNT
+#define GLC_PARAMETER_BUFFER GL_PARAMETER_BUFFER_ARB
+#define glc_multiDrawElementsIndirectCount glMultiDrawElementsIndirectCountARB
+#endif
+
+enum
+{
+	GLC_CULL_NONE, GLC_CULL_ZERO, GLC_CULL_COMPACT
+};
+
+/* The layout glMultiDrawElementsIndirect reads. */
+typedef struct glcDrawElementsCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+} glcDrawElementsCommand;
+
+typedef struct glcDrawList
+{
+	glcStreamBuffer* stream;
+	const glcUniformBlock* block;	/* per-instance data, or NULL */
+	glcDrawElementsCommand* commands;
+	GLfloat* bounds;		/* a sphere per draw with GLC_DRAW_LIST_CULL, else NULL */
+	void* data;				/* the block's storage, NULL without block */
+	GLintptr commandOffset;
+	GLintptr boundsOffset;
+	GLintptr dataOffset;
+	GLsizeiptr dataSize;
+	GLintptr drawOffset;	/* draw list the culling wrote */
+	GLintptr countOffset;	/* and its draw count, when packed */
+	GLsizei drawCount;
+	GLsizei maxDraws;
+	GLuint instanceCount;
+	GLuint maxInstances;
+	int culled;				/* GLC_CULL_* */
+} glcDrawList;
+
+static const char* glc_cullSource =
+	"#version 430\n"
+	"layout(local_size_x = 64) in;\n"
+	"struct GlcCommand { uint count; uint instanceCount; uint firstIndex; int baseVertex; uint baseInstance; };\n"
+	"layout(std430) readonly buffer GlcCommands { GlcCommand glcCommands[]; };\n"
+	"layout(std430) readonly buffer GlcBounds { vec4 glcBounds[]; };\n"
+	"layout(std430) writeonly buffer GlcDraws { GlcCommand glcDraws[]; };\n"
+	"#ifdef GLC_COMPACT\n"
+	"layout(std430) buffer GlcDrawCount { uint glcDrawCount; };\n"
+	"#endif\n"
+	"uniform vec4 glcPlanes[6];\n"
+	"uniform uint glcCommandCount;\n"
+	"void main()\n"
+	"{\n"
+	"	uint i = gl_GlobalInvocationID.x;\n"
+	"	if(i >= glcCommandCount)\n"
+	"		return;\n"
+	"	GlcCommand command = glcCommands[i];\n"
+	"	vec4 sphere = glcBounds[i];\n"
+	"	bool visible = true;\n"
+	"	for(int p = 0; p < 6; p++)\n"
+	"		visible = visible && dot(glcPlanes[p].xyz, sphere.xyz) + glcPlanes[p].w >= -sphere.w * length(glcPlanes[p].xyz);\n"
+	"	visible = visible || sphere.w < 0.0;\n"
+	"#ifdef GLC_COMPACT\n"
+	"	if(visible)\n"
+	"		glcDraws[atomicAdd(glcDrawCount, 1u)] = command;\n"
+	"#else\n"
+	"	if(!visible)\n"
+	"		command.instanceCount = 0u;\n"
+	"	glcDraws[i] = command;\n"
+	"#endif\n"
+	"}\n";
+
+static GLuint glc_cullPrograms[2] = {0, 0};	/* in place, packed */
+
+/* Returns the culling program, building it on first use, or 0 on failure. */
+static GLuint glc_getCullProgram(int compact)
+{
+	int i;
+	GLuint program = glc_cullPrograms[compact];
+	const char* define = "GLC_COMPACT";
+	const char* blocks[4] = { "GlcCommands", "GlcBounds", "GlcDraws", "GlcDrawCount" };
+	glcShaderStage stage;
+
+	if(program && glc_findProgram(program))
+		return program;
+	memset(&stage, 0, sizeof(stage));
+	stage.type = GL_COMPUTE_SHADER;
+	stage.source = glc_cullSource;
+	stage.length = -1;
+	if(glcMakeProgramVariant(&program, &stage, 1, &define, compact) == -1)
+		return 0;
+	for(i = 0; i < 3 + compact; i++)
+		glShaderStorageBlockBinding(program, glGetProgramResourceIndex(program, GL_SHADER_STORAGE_BLOCK, blocks[i]), GLC_CULL_BINDING + i);
+	glc_cullPrograms[compact] = program;
+	return program;
+}
+
+static int glc_indirectCountSupported(glcContext* context)
+{
+	if(context->indirectCount == -1)
+	{
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		context->indirectCount = (major > 4 || (major == 4 && minor >= 6)) || glc_hasExtension("GL_ARB_indirect_parameters");
+	}
+	return context->indirectCount;
+}
+
+/*	glcFrustumPlanes()
+	planes - receives the six planes, four floats each, with their normals
+		pointing inwards
+	viewProjection - column-major view projection matrix the planes are
+		taken from, giving world space planes for world space bounds */
+void glcFrustumPlanes(GLfloat* planes, const GLfloat* viewProjection)
+{
+	int i, j;
+	const GLfloat* m = viewProjection;
+
+	/* the fourth row plus and minus each of the others, left to far */
+	for(i = 0; i < 6; i++)
+	{
+		for(j = 0; j < 4; j++)
+			planes[i * 4 + j] = m[j * 4 + 3] + ((i & 1) ? -m[j * 4 + i / 2] : m[j * 4 + i / 2]);
+	}
+}
+
+/*	glcBeginDrawList()
+	Returns: 1 (success) or -1 (failure)
+	list - pointer to a to be draw list
+	stream - streaming buffer to allocate the commands and data from
+	block - storage block from glcGetStorageBlock the draws read their
+		per-instance data from, or NULL for none
+	maxDraws - most draws that will be added
+	maxInstances - most instances of all draws together, sizing the block
+	flags - 0 or GLC_DRAW_LIST_CULL */
+int glcBeginDrawList(glcDrawList* list, glcStreamBuffer* stream, const glcUniformBlock* block, GLsizei maxDraws, GLuint maxInstances, int flags)
+{
+	GLsizeiptr alignment = sizeof(GLuint);
+	glcContext* context = glc_getContext();
+
+	memset(list, 0, sizeof(glcDrawList));
+	if(maxDraws < 1)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_VALUE, "Draw count invalid. Must be at least 1. Got %d.", maxDraws);
+		return -1;
+	}
+	if(!context->storageAlignment)
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &context->storageAlignment);
+	/* the culling shader reads the commands as a storage buffer */
+	if(flags & GLC_DRAW_LIST_CULL)
+		alignment = context->storageAlignment;
+	list->stream = stream;
+	list->block = block;
+	list->maxDraws = maxDraws;
+	list->maxInstances = maxInstances;
+	if(!(list->commands = (glcDrawElementsCommand*)glcAllocStreamBuffer(stream, maxDraws * sizeof(glcDrawElementsCommand), alignment, &list->commandOffset)))
+		return -1;
+	if((flags & GLC_DRAW_LIST_CULL) &&
+		!(list->bounds = (GLfloat*)glcAllocStreamBuffer(stream, maxDraws * 4 * sizeof(GLfloat), alignment, &list->boundsOffset)))
+		return -1;
+	if(block)
+	{
+		list->dataSize = glcStorageBlockSize(block, (GLsizei)maxInstances);
+		if(!(list->data = glcAllocStreamBuffer(stream, list->dataSize, context->storageAlignment, &list->dataOffset)))
+			return -1;
+	}
+	return 1;
+}
+
+/*	glcAddDrawElements()
+	Returns: index of the draw's first element in the list's per-instance
+	data, which is its base instance, or -1 if the list is full
+	list - draw list begun by glcBeginDrawList
+	count - amount of indices
+	firstIndex - first index in the element buffer, in indices
+	baseVertex - value added to every index
+	instances - amount of instances
+	sphere - with GLC_DRAW_LIST_CULL, the bounding sphere of all instances
+		as x, y, z and radius, or NULL to never cull the draw */
+GLint glcAddDrawElements(glcDrawList* list, GLuint count, GLuint firstIndex, GLint baseVertex, GLuint instances, const GLfloat* sphere)
+{
+	glcDrawElementsCommand* command;
+	static const GLfloat always[4] = { 0.0f, 0.0f, 0.0f, -1.0f };
+
+	if(list->drawCount == list->maxDraws || (list->block && instances > list->maxInstances - list->instanceCount))
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Draw list full. Holds %d draws of %u instances.", list->maxDraws, list->maxInstances);
+		return -1;
+	}
+	command = &list->commands[list->drawCount];
+	command->count = count;
+	command->instanceCount = instances;
+	command->firstIndex = firstIndex;
+	command->baseVertex = baseVertex;
+	command->baseInstance = list->instanceCount;
+	if(list->bounds)
+		memcpy(list->bounds + (size_t)list->drawCount * 4, sphere ? sphere : always, 4 * sizeof(GLfloat));
+	list->drawCount++;
+	list->instanceCount += instances;
+	return (GLint)command->baseInstance;
+}
+
+/*	glcCullDrawList()
+	Returns: 1 (success) or -1 (failure)
+	list - draw list begun with GLC_DRAW_LIST_CULL, with all draws added
+	planes - six planes of four floats, inside where the plane equation is
+		positive, such as from glcFrustumPlanes. They need not be normalised.
+	Writes the visible draws to a new list on the GPU, which
+	glcSubmitDrawList then draws. Call once after the last draw is added.
+	The culling shader is bound only for the dispatch; the program bound
+	before, if any, is bound again on return. */
+int glcCullDrawList(glcDrawList* list, const GLfloat* planes)
+{
+	int compact = 0, result;
+	GLint current;
+	GLuint program, buffer = list->stream->buffer;
+	GLuint* drawCount;
+	GLsizeiptr size = list->drawCount * sizeof(glcDrawElementsCommand);
+	glcContext* context = glc_getContext();
+
+	if(!list->bounds || list->culled)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Draw list was not begun with GLC_DRAW_LIST_CULL or is culled already.");
+		return -1;
+	}
+	if(!list->drawCount)
+		return 1;
+#ifdef GLC_INDIRECT_COUNT
+	compact = glc_indirectCountSupported(context);
+#else
+	(void)context;
+#endif
+	if(!(program = glc_getCullProgram(compact)))
+		return -1;
+	if(!glcAllocStreamBuffer(list->stream, size, context->storageAlignment, &list->drawOffset))
+		return -1;
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, GLC_CULL_BINDING, buffer, list->commandOffset, size);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, GLC_CULL_BINDING + 1, buffer, list->boundsOffset, list->drawCount * 4 * sizeof(GLfloat));
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, GLC_CULL_BINDING + 2, buffer, list->drawOffset, size);
+	if(compact)
+	{
+		if(!(drawCount = (GLuint*)glcAllocStreamBuffer(list->stream, sizeof(GLuint), context->storageAlignment, &list->countOffset)))
+			return -1;
+		*drawCount = 0;
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, GLC_CULL_BINDING + 3, buffer, list->countOffset, sizeof(GLuint));
+	}
+	/* the draw program, which the dispatch and the uniform setters replace */
+	if((current = (GLint)context->currentProgram) == (GLint)GLC_UNKNOWN_PROGRAM)
+		glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+	glcSetUniform4fv(program, "glcPlanes", 6, planes);
+	glcSetUniform1ui(program, "glcCommandCount", (GLuint)list->drawCount);
+	result = glcDispatchCompute(program, (GLuint)list->drawCount, 1, 1);
+	glcUseProgram((GLuint)current);
+	if(result == -1)
+		return -1;
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+	list->culled = compact ? GLC_CULL_COMPACT : GLC_CULL_ZERO;
+	return 1;
+}
+
+/*	glcSubmitDrawList()
+	list - draw list begun by glcBeginDrawList
+	mode - primitive type, such as GL_TRIANGLES
+	type - type of the indices, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	Draws every draw added, or what glcCullDrawList left of them, with the
+	bound program, vertex array and element buffer, after binding the
+	per-instance data to its block. Culling leaves the draw program bound,
+	so the usual order is bind, add draws, cull, submit. A list can be submitted any number of
+	times until its stream space is reused. */
+void glcSubmitDrawList(const glcDrawList* list, GLenum mode, GLenum type)
+{
+	GLuint buffer = list->stream->buffer;
+
+	if(!list->drawCount)
+		return;
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+	if(list->block)
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, list->block->binding, buffer, list->dataOffset, list->dataSize);
+#ifdef GLC_INDIRECT_COUNT
+	if(list->culled == GLC_CULL_COMPACT)
+	{
+		glBindBuffer(GLC_PARAMETER_BUFFER, buffer);
+		glc_multiDrawElementsIndirectCount(mode, type, (const void*)list->drawOffset, list->countOffset, list->drawCount, 0);
+		/* Mesa takes a bound parameter buffer's count for plain indirect draws too */
+		glBindBuffer(GLC_PARAMETER_BUFFER, 0);
+		return;
+	}
+#endif
+	glMultiDrawElementsIndirect(mode, type, (const void*)(list->culled ? list->drawOffset : list->commandOffset), list->drawCount, 0);
+}
+
+#endif
+
+/*	Command buffers
+	Recording lets worker threads prepare draws while all GL calls stay on
+	the render thread. The glcRecord* functions append compact commands to a
+	glcCommandBuffer, a linear arena owned by the recording thread, and never
+	call GL; uniform handles are resolved beforehand with glcGetUniformHandle.
+	glcSubmitCommandBuffers() then replays any number of buffers on the
+	render thread, optionally grouping the draws by program (GLC_SUBMIT_SORT)
+	while keeping their recorded order within each program.
+	Program, vertex array and indexed buffer binds are not replayed as they
+	come but folded into the next draw, so replay only binds what differs
+	from what the previous draw left bound, whichever buffer it came from.
+	Each buffer starts out with nothing bound and must record all the state
+	its draws rely on. Uniform sets are replayed in order right before the
+	draw recorded after them, through the uniform shadow where that is on,
+	so when sorting only set uniforms of the program that draw uses.
+	Arenas are kept by glcResetCommandBuffer and only grow up to the largest
+	frame recorded. */
+#if defined(GL_VERSION_3_2) || defined(GL_ARB_draw_elements_base_vertex)
+
+#define GLC_COMMAND_BINDINGS 16	/* buffer binding points one command buffer tracks */
+#define GLC_SUBMIT_SORT 1		/* glcSubmitCommandBuffers flag */
+
+enum
+{
+	GLC_COMMAND_UNIFORM, GLC_COMMAND_BINDING_SET, GLC_COMMAND_DRAW
+};
+
+typedef struct glcCommandBinding
+{
+	GLenum target;
+	GLuint index;
+	GLuint buffer;
+	GLintptr offset;
+	GLsizeiptr size;	/* 0 binds the whole buffer */
+} glcCommandBinding;
+
+typedef struct glcCommandBuffer
+{
+	unsigned char* data;
+	size_t size;
+	size_t capacity;
+	int drawCount;
+	int failed;			/* a command was lost, the buffer is not replayed */
+	/* state recorded so far, folded into every draw */
+	GLuint program;
+	GLuint vertexArray;
+	int bindingCount;
+	int bindingsChanged;
+	size_t bindingSet;	/* offset of the last binding set written */
+	glcCommandBinding bindings[GLC_COMMAND_BINDINGS];
+} glcCommandBuffer;
+
+/* Every command starts with this header and is padded to 8 bytes. */
+typedef struct glcCommand
+{
+	unsigned int type;
+	unsigned int size;	/* bytes including the header */
+} glcCommand;
+
+typedef struct glcUniformCommand
+{
+	glcCommand header;
+	glcUniformHandle h;
+	int kind;
+	GLsizei count;
+} glcUniformCommand;	/* followed by the values, column-major */
+
+/* A binding set is a glcCommand followed by glcCommandBinding entries. */
+
+typedef struct glcDrawCommand
+{
+	glcCommand header;
+	GLuint program;
+	GLuint vertexArray;
+	GLenum mode;
+	GLenum type;		/* index type, 0 for glDrawArrays */
+	GLint first;		/* first vertex, arrays only */
+	GLsizei count;
+	GLsizei instances;
+	GLint baseVertex;
+	GLintptr offset;	/* byte offset of the first index */
+	size_t bindings;	/* offset of the binding set, or ~0 if none */
+} glcDrawCommand;
+
+typedef struct glcCommandPacket
+{
+	unsigned long long key;		/* program, then submission order */
+	const glcCommandBuffer* buffer;
+	size_t start;				/* first command */
+	size_t end;					/* one past the draw */
+} glcCommandPacket;
+
+/*	glcMakeCommandBuffer()
+	buffer - pointer to a to be command buffer */
+void glcMakeCommandBuffer(glcCommandBuffer* buffer)
+{
+	memset(buffer, 0, sizeof(glcCommandBuffer));
+	buffer->bindingSet = ~(size_t)0;
+}
+
+/*	glcResetCommandBuffer()
+	buffer - command buffer made by glcMakeCommandBuffer
+	Drops every command and the recorded state, keeping the arena. */
+void glcResetCommandBuffer(glcCommandBuffer* buffer)
+{
+	unsigned char* data = buffer->data;
+	size_t capacity = buffer->capacity;
+
+	glcMakeCommandBuffer(buffer);
+	buffer->data = data;
+	buffer->capacity = capacity;
+}
+
+/*	glcDeleteCommandBuffer()
+	buffer - command buffer made by glcMakeCommandBuffer */
+void glcDeleteCommandBuffer(glcCommandBuffer* buffer)
+{
+	free(buffer->data);
+	glcMakeCommandBuffer(buffer);
+}
+
+static void* glc_allocCommand(glcCommandBuffer* buffer, unsigned int type, size_t size)
+{
+	glcCommand* command;
+
+	size = (size + 7) & ~(size_t)7;
+	if(buffer->failed)
+		return NULL;
+	if(buffer->size + size > buffer->capacity)
+	{
+		size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+		unsigned char* data;
+		while(capacity < buffer->size + size)
+			capacity *= 2;
+		if(!(data = (unsigned char*)realloc(buffer->data, capacity)))
+		{
+			GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when recording commands.");
+			buffer->failed = 1;
+			return NULL;
+		}
+		buffer->data = data;
+		buffer->capacity = capacity;
+	}
+	command = (glcCommand*)(buffer->data + buffer->size);
+	command->type = type;
+	command->size = (unsigned int)size;
+	buffer->size += size;
+	return command;
+}
+
+/*	glcRecordUseProgram()
+	buffer - command buffer made by glcMakeCommandBuffer
+	program - shader program handle for the draws that follow, or 0 */
+void glcRecordUseProgram(glcCommandBuffer* buffer, GLuint program)
+{
+	buffer->program = program;
+}
+
+/*	glcRecordBindVertexArray()
+	buffer - command buffer made by glcMakeCommandBuffer
+	vertexArray - vertex array object for the draws that follow */
+void glcRecordBindVertexArray(glcCommandBuffer* buffer, GLuint vertexArray)
+{
+	buffer->vertexArray = vertexArray;
+}
+
+/*	glcRecordBindBufferRange()
+	Returns: 1 (success) or -1 (failure)
+	buffer - command buffer made by glcMakeCommandBuffer
+	target - indexed target, such as GL_UNIFORM_BUFFER or
+		GL_SHADER_STORAGE_BUFFER
+	index - binding point
+	object - buffer object to bind
+	offset - start of the range
+	size - bytes of the range, or 0 to bind the whole buffer */
+int glcRecordBindBufferRange(glcCommandBuffer* buffer, GLenum target, GLuint index, GLuint object, GLintptr offset, GLsizeiptr size)
+{
+	int i;
+	glcCommandBinding* binding;
+
+	for(i = 0; i < buffer->bindingCount && (buffer->bindings[i].target != target || buffer->bindings[i].index != index); i++);
+	if(i == GLC_COMMAND_BINDINGS)
+	{
+		GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Command buffer binds more than %d buffer binding points.", GLC_COMMAND_BINDINGS);
+		return -1;
+	}
+	binding = &buffer->bindings[i];
+	if(i < buffer->bindingCount && binding->buffer == object && binding->offset == offset && binding->size == size)
+		return 1;
+	if(i == buffer->bindingCount)
+		buffer->bindingCount++;
+	binding->target = target;
+	binding->index = index;
+	binding->buffer = object;
+	binding->offset = offset;
+	binding->size = size;
+	buffer->bindingsChanged = 1;
+	return 1;
+}
+
+static int glc_recordUniform(glcCommandBuffer* buffer, glcUniformHandle h, int kind, GLsizei count, GLboolean transpose, const void* value)
+{
+	int i, r, c, columns = glc_kindShape[kind][0], rows = glc_kindShape[kind][1];
+	size_t size = (size_t)columns * rows * 4;
+	const GLfloat* src = (const GLfloat*)value;
+	GLfloat* dst;
+	glcUniformCommand* command;
+
+	GLC_VALIDATE_UNIFORM(h, kind, count);
+	if(h.location < 0 || count < 1)
+		return 1;
+	if(!(command = (glcUniformCommand*)glc_allocCommand(buffer, GLC_COMMAND_UNIFORM, sizeof(glcUniformCommand) + count * size)))
+		return -1;
+	command->h = h;
+	command->kind = kind;
+	command->count = count;
+	dst = (GLfloat*)(command + 1);
+	if(!transpose)
+	{
+		memcpy(dst, value, count * size);
+		return 1;
+	}
+	for(i = 0; i < count; i++, src += columns * rows, dst += columns * rows)
+		for(c = 0; c < columns; c++)
+			for(r = 0; r < rows; r++)
+				dst[c * rows + r] = src[r * columns + c];
+	return 1;
+}
+
+#define GLC_DEFINE_RECORD_UNIFORM(suffix, kind, T) \
+int glcRecordUniform##suffix(glcCommandBuffer* buffer, glcUniformHandle h, GLsizei count, const T* value) \
+{ \
+	return glc_recordUniform(buffer, h, kind, count, GL_FALSE, value); \
+}
+
+#define GLC_DEFINE_RECORD_MATRIX(suffix, kind) \
+int glcRecordUniformMatrix##suffix##fv(glcCommandBuffer* buffer, glcUniformHandle h, GLsizei count, GLboolean transpose, const GLfloat* value) \
+{ \
+	return glc_recordUniform(buffer, h, kind, count, transpose, value); \
+}
+
+/*	glcRecordUniform{1,2,3,4}{f,i,ui}v()
+	glcRecordUniformMatrix{2,3,4,2x3,3x2,2x4,4x2,3x4,4x3}fv()
+	Returns: 1 (success) or -1 (failure)
+	buffer - command buffer made by glcMakeCommandBuffer
+	h - uniform handle from glcGetUniformHandle
+	Remaining parameters are those of glUniform*v. The values are copied. */
+GLC_DEFINE_RECORD_UNIFORM(1fv, GLC_UNIFORM_FLOAT, GLfloat)
+GLC_DEFINE_RECORD_UNIFORM(2fv, GLC_UNIFORM_VEC2, GLfloat)
+GLC_DEFINE_RECORD_UNIFORM(3fv, GLC_UNIFORM_VEC3, GLfloat)
+GLC_DEFINE_RECORD_UNIFORM(4fv, GLC_UNIFORM_VEC4, GLfloat)
+GLC_DEFINE_RECORD_UNIFORM(1iv, GLC_UNIFORM_INT, GLint)
+GLC_DEFINE_RECORD_UNIFORM(2iv, GLC_UNIFORM_IVEC2, GLint)
+GLC_DEFINE_RECORD_UNIFORM(3iv, GLC_UNIFORM_IVEC3, GLint)
+GLC_DEFINE_RECORD_UNIFORM(4iv, GLC_UNIFORM_IVEC4, GLint)
+GLC_DEFINE_RECORD_UNIFORM(1uiv, GLC_UNIFORM_UINT, GLuint)
+GLC_DEFINE_RECORD_UNIFORM(2uiv, GLC_UNIFORM_UVEC2, GLuint)
+GLC_DEFINE_RECORD_UNIFORM(3uiv, GLC_UNIFORM_UVEC3, GLuint)
+GLC_DEFINE_RECORD_UNIFORM(4uiv, GLC_UNIFORM_UVEC4, GLuint)
+GLC_DEFINE_RECORD_MATRIX(2, GLC_UNIFORM_MAT2)
+GLC_DEFINE_RECORD_MATRIX(3, GLC_UNIFORM_MAT3)
+GLC_DEFINE_RECORD_MATRIX(4, GLC_UNIFORM_MAT4)
+GLC_DEFINE_RECORD_MATRIX(2x3, GLC_UNIFORM_MAT2X3)
+GLC_DEFINE_RECORD_MATRIX(3x2, GLC_UNIFORM_MAT3X2)
+GLC_DEFINE_RECORD_MATRIX(2x4, GLC_UNIFORM_MAT2X4)
+GLC_DEFINE_RECORD_MATRIX(4x2, GLC_UNIFORM_MAT4X2)
+GLC_DEFINE_RECORD_MATRIX(3x4, GLC_UNIFORM_MAT3X4)
+GLC_DEFINE_RECORD_MATRIX(4x3, GLC_UNIFORM_MAT4X3)
+
+static int glc_recordDraw(glcCommandBuffer* buffer, const glcDrawCommand* values)
+{
+	glcCommand* set;
+	glcDrawCommand* draw;
+
+	/* bindings are stored again only when they changed since the last draw */
+	if(buffer->bindingsChanged)
+	{
+		if(!(set = (glcCommand*)glc_allocCommand(buffer, GLC_COMMAND_BINDING_SET, sizeof(glcCommand) + buffer->bindingCount * sizeof(glcCommandBinding))))
+			return -1;
+		memcpy(set + 1, buffer->bindings, buffer->bindingCount * sizeof(glcCommandBinding));
+		buffer->bindingSet = (size_t)((unsigned char*)set - buffer->data);
+		buffer->bindingsChanged = 0;
+	}
+	if(!(draw = (glcDrawCommand*)glc_allocCommand(buffer, GLC_COMMAND_DRAW, sizeof(glcDrawCommand))))
+		return -1;
+	memcpy((glcCommand*)draw + 1, (const glcCommand*)values + 1, sizeof(glcDrawCommand) - sizeof(glcCommand));
+	draw->program = buffer->program;
+	draw->vertexArray = buffer->vertexArray;
+	draw->bindings = buffer->bindingSet;
+	buffer->drawCount++;
+	return 1;
+}
+
+/*	glcRecordDrawArrays()
+	Returns: 1 (success) or -1 (failure)
+	buffer - command buffer made by glcMakeCommandBuffer
+	instances - instance count, 1 for a plain draw
+	Remaining parameters are those of glDrawArrays. */
+int glcRecordDrawArrays(glcCommandBuffer* buffer, GLenum mode, GLint first, GLsizei count, GLsizei instances)
+{
+	glcDrawCommand draw;
+
+	memset(&draw, 0, sizeof(draw));
+	draw.mode = mode;
+	draw.first = first;
+	draw.count = count;
+	draw.instances = instances;
+	return glc_recordDraw(buffer, &draw);
+}
+
+/*	glcRecordDrawElements()
+	Returns: 1 (success) or -1 (failure)
+	buffer - command buffer made by glcMakeCommandBuffer
+	offset - byte offset of the first index in the element array buffer
+	instances - instance count, 1 for a plain draw
+	baseVertex - value added to every index
+	Remaining parameters are those of glDrawElements. */
+int glcRecordDrawElements(glcCommandBuffer* buffer, GLenum mode, GLsizei count, GLenum type, GLintptr offset, GLsizei instances, GLint baseVertex)
+{
+	glcDrawCommand draw;
+
+	memset(&draw, 0, sizeof(draw));
+	draw.mode = mode;
+	draw.type = type;
+	draw.count = count;
+	draw.offset = offset;
+	draw.instances = instances;
+	draw.baseVertex = baseVertex;
+	return glc_recordDraw(buffer, &draw);
+}
+
+static void glc_addPacket(glcCommandPacket* packet, const glcCommandBuffer* buffer, size_t start, size_t end, GLuint program, int index)
+{
+	packet->key = (unsigned long long)program << 32 | (unsigned int)index;
+	packet->buffer = buffer;
+	packet->start = start;
+	packet->end = end;
+}
+
+static int glc_comparePackets(const void* a, const void* b)
+{
+	unsigned long long x = ((const glcCommandPacket*)a)->key, y = ((const glcCommandPacket*)b)->key;
+	return (x > y) - (x < y);
+}
+
+#define GLC_REPLAY_BINDINGS (GLC_COMMAND_BINDINGS * 2)
+
+typedef struct glcReplayState
+{
+	int boundCount;
+	glcCommandBinding bound[GLC_REPLAY_BINDINGS];	/* what replay bound so far */
+} glcReplayState;
+
+static void glc_replayPacket(glcReplayState* state, const glcCommandPacket* packet)
+{
+	int i, j, count;
+	size_t at;
+	const unsigned char* data = packet->buffer->data;
+	const glcCommand* command;
+	const glcCommandBinding* binding;
+	const glcDrawCommand* draw = NULL;
+	glcProgramInfo* info;
+
+	for(at = packet->start; at < packet->end; at += command->size)
+	{
+		command = (const glcCommand*)(data + at);
+		if(command->type == GLC_COMMAND_UNIFORM)
+		{
+			const glcUniformCommand* uniform = (const glcUniformCommand*)command;
+			if(!GLC_LOAD_INT(&glc_uniformHooks) || !glc_interceptUniform(uniform->h, uniform->kind, uniform->count, GL_FALSE, uniform + 1))
+				glc_uploadUniform(uniform->h, uniform->kind, uniform->count, uniform + 1);
+		}
+		else if(command->type == GLC_COMMAND_DRAW)
+			draw = (const glcDrawCommand*)command;
+	}
+	if(!draw)
+		return;
+	glcUseProgram(draw->program);
+	glcBindVertexArray(draw->vertexArray);
+	if(draw->bindings != ~(size_t)0)
+	{
+		command = (const glcCommand*)(data + draw->bindings);
+		binding = (const glcCommandBinding*)(command + 1);
+		count = (int)((command->size - sizeof(glcCommand)) / sizeof(glcCommandBinding));
+		for(i = 0; i < count; i++, binding++)
+		{
+			for(j = 0; j < state->boundCount && (state->bound[j].target != binding->target || state->bound[j].index != binding->index); j++);
+			if(j < state->boundCount && state->bound[j].buffer == binding->buffer && state->bound[j].offset == binding->offset && state->bound[j].size == binding->size)
+				continue;
+			/* past the table the binding is simply never skipped */
+			if(j < GLC_REPLAY_BINDINGS)
+			{
+				state->bound[j] = *binding;
+				if(j == state->boundCount)
+					state->boundCount++;
+			}
+			if(binding->size)
+				glBindBufferRange(binding->target, binding->index, binding->buffer, binding->offset, binding->size);
+			else
+				glBindBufferBase(binding->target, binding->index, binding->buffer);
+		}
+	}
+	if(GLC_LOAD_INT(&glc_uniformHooks) && (info = glc_findProgram(draw->program)) && info->uniformMode == GLC_UNIFORMS_DEFERRED)
+		glcFlushUniforms(draw->program);
+	if(draw->type)
+		glDrawElementsInstancedBaseVertex(draw->mode, draw->count, draw->type, (const void*)draw->offset, draw->instances, draw->baseVertex);
+	else
+		glDrawArraysInstanced(draw->mode, draw->first, draw->count, draw->instances);
+}
+
+/*	glcSubmitCommandBuffers()
+	Returns: 1 (success) or -1 (failure)
+	buffers - command buffers to replay, in order
+	count - amount of buffers
+	flags - 0, or GLC_SUBMIT_SORT to group the draws by program
+	Replays on the calling thread, which must have the GL context current.
+	Buffers that lost a command while recording are skipped. The buffers
+	are left as they are, reset them before recording the next frame. The
+	state of the last draw stays bound. */
+int glcSubmitCommandBuffers(glcCommandBuffer* const* buffers, int count, int flags)
+{
+	int i, packetCount = 0, total = 0, result = 1;
+	size_t at, start;
+	const glcCommand* command;
+	glcReplayState state;
+	glcContext* context = glc_getContext();
+
+	for(i = 0; i < count; i++)
+		total += buffers[i]->drawCount + 1;
+	if(total > context->packetCapacity)
+	{
+		glcCommandPacket* packets = (glcCommandPacket*)realloc(context->packets, total * sizeof(glcCommandPacket));
+		if(!packets)
+		{
+			GLC_LOG(GLC_ERROR_OUT_OF_MEMORY, "Error allocating memory when submitting command buffers.");
+			return -1;
+		}
+		context->packets = packets;
+		context->packetCapacity = total;
+	}
+	for(i = 0; i < count; i++)
+	{
+		if(buffers[i]->failed)
+		{
+			GLC_LOG(GLC_ERROR_INVALID_OPERATION, "Command buffer %d lost commands while recording, skipped.", i);
+			result = -1;
+			continue;
+		}
+		for(start = at = 0; at < buffers[i]->size; at += command->size)
+		{
+			command = (const glcCommand*)(buffers[i]->data + at);
+			if(command->type != GLC_COMMAND_DRAW)
+				continue;
+			glc_addPacket(&context->packets[packetCount], buffers[i], start, at + command->size, ((const glcDrawCommand*)command)->program, packetCount);
+			packetCount++;
+			start = at + command->size;
+		}
+		/* uniform sets after the last draw go last */
+		if(start < buffers[i]->size)
+		{
+			glc_addPacket(&context->packets[packetCount], buffers[i], start, buffers[i]->size, GLC_UNKNOWN_PROGRAM, packetCount);
+			packetCount++;
+		}
+	}
+	if(flags & GLC_SUBMIT_SORT)
+		qsort(context->packets, packetCount, sizeof(glcCommandPacket), glc_comparePackets);
+	state.boundCount = 0;
+	for(i = 0; i < packetCount; i++)
+		glc_replayPacket(&state, &context->packets[i]);
+	return result;
+}
+
+#endif
+
+/*	glcDeleteContext()
+	context - glc context made by glcMakeContext, or NULL for the default one
+	Call while the context's GL context is current on this thread and before
+	destroying it: deletes the program pipelines, vertex arrays and GPU timer
+	queries glc made for it and drops the residency of its texture handles.
+	Shared state such as programs is left alone. */
+void glcDeleteContext(glcContext* context)
+{
+	int i;
+
+	(void)i;
+	if(!context && !GLC_LOAD_INT(&glc_defaultReady))
+		return;
+	if(!context)
+		context = &glc_defaultContext;
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_separate_shader_objects)
+	for(i = 0; i < context->pipelineCapacity; i++)
+	{
+		if(context->pipelines[i].key)
+			glDeleteProgramPipelines(1, &context->pipelines[i].pipeline);
+	}
+#endif
+#if defined(GL_VERSION_4_3) || defined(GL_ARB_vertex_attrib_binding)
+	for(i = 0; i < context->vertexArrayCapacity; i++)
+	{
+		if(context->vertexArrays[i].key)
+			glDeleteVertexArrays(1, &context->vertexArrays[i].vertexArray);
+	}
+#endif
+#ifdef GL_ARB_bindless_texture
+	for(i = 0; i < context->residentCapacity; i++)
+	{
+		if(context->residentHandles[i].handle)
+			glMakeTextureHandleNonResidentARB(context->residentHandles[i].handle);
+	}
+#endif
+#if defined(GLC_STATS) && (defined(GL_VERSION_3_3) || defined(GL_ARB_timer_query))
+	if(context->runningTimer != -1)
+		glEndQuery(GL_TIME_ELAPSED);
+	for(i = 0; i < GLC_MAX_GPU_TIMERS; i++)
+	{
+		if(context->gpuTimers[i].queries[0])
+			glDeleteQueries(GLC_GPU_TIMER_LATENCY, context->gpuTimers[i].queries);
+	}
+#endif
+	free(context->pipelines);
+	free(context->vertexArrays);
+	free(context->residentHandles);
+	free(context->packets);
+	if(glc_context == context)
+		glc_context = NULL;
+	glcMakeContext(context);
+}
+
+#endif
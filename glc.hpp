@@ -0,0 +1,248 @@
+/*	---------------------------------------------------------------------
+ *	glc.hpp - C++ ownership layer for glc.h
+ *	Move-only owners for shader and program objects, so a handle is
+ *	deleted exactly once no matter how it leaves scope. Requires C++11.
+ *
+ *	Copyright 2017 Patrick Cland
+ *	www.setsunasoft.com
+ *
+ *	Same license as glc.h.
+ *	----------------------------------------------------------------------------- */
+
+#ifndef GLC_HPP
+#define GLC_HPP
+
+#include "glc.h"
+
+namespace glc
+{
+
+/*	glc::Shader
+	Owns a single compiled shader object, for linking several programs
+	from the same compiled stage. Errors are reported like the glc.h
+	functions: returns of 1 (success) or -1 (failure) and a message through
+	GLC_LOG to the log callback (stderr unless replaced through
+	glcSetLogCallback, nowhere once set to NULL). */
+class Shader
+{
+public:
+	Shader() : id(0) {}
+	~Shader() { reset(); }
+	Shader(Shader&& other) noexcept : id(other.id) { other.id = 0; }
+	Shader& operator=(Shader&& other) noexcept
+	{
+		if(this != &other)
+		{
+			reset();
+			id = other.id;
+			other.id = 0;
+		}
+		return *this;
+	}
+	Shader(const Shader&) = delete;
+	Shader& operator=(const Shader&) = delete;
+
+	/*	compile()
+		Returns: 1 (success) or -1 (failure)
+		type - shader stage, such as GL_VERTEX_SHADER
+		source - GLSL source code or a SPIR-V module
+		length - length of source, or -1 if null terminated GLSL
+		Replaces any shader held before. On failure nothing is held. */
+	int compile(GLenum type, const char* source, GLint length = -1)
+	{
+		GLint success = 0;
+		char* log;
+		GLuint shader = glCreateShader(type);
+
+		if(!shader)
+		{
+			GLC_LOG(GLC_ERROR_GL_OBJECT, "Error creating %s shader object.", glc_stageName(type, 0));
+			return -1;
+		}
+		if(length < 0)
+			length = (GLint)strlen(source);
+		if(glc_compileShader(shader, source, length) == -1)
+		{
+			glDeleteShader(shader);
+			return -1;
+		}
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if(!success)
+		{
+			log = glc_getInfoLog(shader, GL_FALSE);
+			GLC_LOG(GLC_ERROR_COMPILE, "%s shader compilation error!\n%s", glc_stageName(type, 1), log ? log : "");
+			free(log);
+			glDeleteShader(shader);
+			return -1;
+		}
+		reset();
+		id = shader;
+		return 1;
+	}
+
+	/*	load()
+		Returns: 1 (success) or -1 (failure)
+		type - shader stage, such as GL_VERTEX_SHADER
+		path - path to a GLSL source or SPIR-V file */
+	int load(GLenum type, const char* path)
+	{
+		int result;
+		char* source;
+		GLint length;
+
+		if(glcLoadShaderSource(path, &source, &length) == -1)
+			return -1;
+		result = compile(type, source, length);
+		free(source);
+		return result;
+	}
+
+	void reset()
+	{
+		if(id)
+			glDeleteShader(id);
+		id = 0;
+	}
+	/* gives up ownership without deleting */
+	GLuint release()
+	{
+		GLuint shader = id;
+		id = 0;
+		return shader;
+	}
+	GLuint get() const { return id; }
+	explicit operator bool() const { return id != 0; }
+
+private:
+	GLuint id;
+};
+
+/*	glc::Program
+	Owns a shader program and the state glc caches for it; the destructor
+	runs glcDeleteShaderProgram. The make functions mirror their glc.h
+	counterparts and replace the program held before only if they succeed.
+	Do not hand get() to glcWatchProgram: a reload would delete the owned
+	program behind the owner's back. */
+class Program
+{
+public:
+	Program() : id(0) {}
+	/* adopts a program built through glc.h */
+	explicit Program(GLuint program) : id(program) {}
+	~Program() { reset(); }
+	Program(Program&& other) noexcept : id(other.id) { other.id = 0; }
+	Program& operator=(Program&& other) noexcept
+	{
+		if(this != &other)
+		{
+			reset();
+			id = other.id;
+			other.id = 0;
+		}
+		return *this;
+	}
+	Program(const Program&) = delete;
+	Program& operator=(const Program&) = delete;
+
+	int make(const glcShaderStage* stages, int count)
+	{
+		GLuint program;
+		int result = glcMakeProgram(&program, stages, count);
+		return adopt(result, program);
+	}
+	int make(const char* vertexShaderPath, const char* fragmentShaderPath)
+	{
+		GLuint program;
+		int result = glcMakeShaderProgram(&program, vertexShaderPath, fragmentShaderPath);
+		return adopt(result, program);
+	}
+	int makeSource(const char* vertexSource, const char* fragmentSource)
+	{
+		GLuint program;
+		int result = glcMakeShaderProgramSource(&program, vertexSource, -1, fragmentSource, -1);
+		return adopt(result, program);
+	}
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_separate_shader_objects)
+	int makeSeparable(const glcShaderStage* stages, int count)
+	{
+		GLuint program;
+		int result = glcMakeSeparableProgram(&program, stages, count);
+		return adopt(result, program);
+	}
+#endif
+
+	/*	link()
+		Returns: 1 (success) or -1 (failure)
+		shaders - compiled shaders, still owned by the caller
+		count - amount of shaders */
+	int link(const Shader* shaders, int count)
+	{
+		int i;
+		GLint success = 0;
+		char* log;
+		GLuint program = glCreateProgram();
+
+		if(!program)
+		{
+			GLC_LOG(GLC_ERROR_GL_OBJECT, "Error creating shader program object.");
+			return -1;
+		}
+		for(i = 0; i < count; i++)
+			glAttachShader(program, shaders[i].get());
+		glLinkProgram(program);
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		for(i = 0; i < count; i++)
+			glDetachShader(program, shaders[i].get());
+		if(!success)
+		{
+			log = glc_getInfoLog(program, GL_TRUE);
+			GLC_LOG(GLC_ERROR_LINK, "Shader program linking error!\n%s", log ? log : "");
+			free(log);
+			glDeleteProgram(program);
+			return -1;
+		}
+		if(glcCacheUniformLocations(program) == -1)
+		{
+			glcDeleteShaderProgram(program);
+			return -1;
+		}
+		return adopt(1, program);
+	}
+
+	void use() const { glcUseProgram(id); }
+	glcUniformHandle uniform(const char* name) const { return glcGetUniformHandle(id, name); }
+	GLint location(const char* name) const { return glcGetUniformLocation(id, name); }
+
+	void reset()
+	{
+		if(id)
+			glcDeleteShaderProgram(id);
+		id = 0;
+	}
+	/* gives up ownership without deleting */
+	GLuint release()
+	{
+		GLuint program = id;
+		id = 0;
+		return program;
+	}
+	GLuint get() const { return id; }
+	explicit operator bool() const { return id != 0; }
+
+private:
+	int adopt(int result, GLuint program)
+	{
+		if(result == 1)
+		{
+			reset();
+			id = program;
+		}
+		return result;
+	}
+
+	GLuint id;
+};
+
+}
+
+#endif
@@ -0,0 +1,201 @@
+/*	---------------------------------------------------------------------
+ *	glc_spirv.c - offline shader validation and SPIR-V compiler for glc.h
+ *	Runs every shader through the glc preprocessor, so #include and
+ *	injected defines behave exactly as in glcPreprocessShader and
+ *	glcMakeProgramVariant, then compiles the result to an OpenGL SPIR-V
+ *	module with glslangValidator. The full compiler output of every
+ *	failing shader is printed and the exit status is the number of
+ *	failures (at most 125), so a build step or commit hook catches shader
+ *	errors before anything runs. The modules load anywhere glc takes a
+ *	shader path.
+ *
+ *	Build (needs glslangValidator on the PATH at run time):
+ *		cc -O2 -o glc_spirv tools/glc_spirv.c -lGL
+ *	Run:
+ *		./glc_spirv [-o directory] [-D NAME[=VALUE]]... [--glslang path] shader...
+ *
+ *	The stage comes from the extension: .vert, .tesc, .tese, .geom, .frag
+ *	or .comp. Each shader.frag is written to shader.frag.spv, next to the
+ *	source or in the -o directory. Error lines read source:line, where
+ *	source 0 is the shader itself and includes are numbered in the order
+ *	they are first entered.
+ *
+ *	Copyright 2017 Patrick Cland
+ *	www.setsunasoft.com
+ *
+ *	Same license as glc.h.
+ *	----------------------------------------------------------------------------- */
+
+#define _POSIX_C_SOURCE 200809L
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include "../glc.h"
+#if defined(_WIN32)
+#define popen _popen
+#define pclose _pclose
+#else
+#include <signal.h>
+#endif
+
+#define SPIRV_MAX_DEFINES 64
+#define SPIRV_MAX_PATH 4096
+
+typedef struct spirvStage
+{
+	const char* extension;
+	const char* name;		/* glslangValidator -S argument */
+	GLenum type;
+} spirvStage;
+
+static const spirvStage spirvStages[] =
+{
+	{ ".vert", "vert", GL_VERTEX_SHADER },
+	{ ".tesc", "tesc", GL_TESS_CONTROL_SHADER },
+	{ ".tese", "tese", GL_TESS_EVALUATION_SHADER },
+	{ ".geom", "geom", GL_GEOMETRY_SHADER },
+	{ ".frag", "frag", GL_FRAGMENT_SHADER },
+	{ ".comp", "comp", GL_COMPUTE_SHADER }
+};
+
+static const spirvStage* spirvFindStage(const char* path)
+{
+	size_t i, length = strlen(path);
+
+	for(i = 0; i < sizeof(spirvStages) / sizeof(spirvStages[0]); i++)
+	{
+		if(length > 5 && !strcmp(path + length - 5, spirvStages[i].extension))
+			return &spirvStages[i];
+	}
+	return NULL;
+}
+
+static void spirvUsage(void)
+{
+	fprintf(stderr, "usage: glc_spirv [-o directory] [-D NAME[=VALUE]]... [--glslang path] shader...\n");
+}
+
+/* Builds the module path: the source path, or its file name inside
+   directory, with .spv appended. Returns 1 (success) or -1 (failure). */
+static int spirvOutputPath(char* output, const char* path, const char* directory)
+{
+	const char* name = path;
+	const char* c;
+	int written;
+
+	if(directory)
+	{
+		for(c = path; *c; c++)
+		{
+			if(*c == '/' || *c == '\\')
+				name = c + 1;
+		}
+		written = snprintf(output, SPIRV_MAX_PATH, "%s/%s.spv", directory, name);
+	}
+	else
+		written = snprintf(output, SPIRV_MAX_PATH, "%s.spv", path);
+	return (written > 0 && written < SPIRV_MAX_PATH) ? 1 : -1;
+}
+
+/* Preprocesses and compiles one shader. Returns 1 (success) or -1 (failure). */
+static int spirvCompile(const char* path, const char* directory, const char* glslang, const char* const* defines, int defineCount)
+{
+	int status;
+	char output[SPIRV_MAX_PATH], command[3 * SPIRV_MAX_PATH];
+	char* source;
+	GLint length;
+	FILE* pipe;
+	glcShaderStage stage;
+	const spirvStage* kind = spirvFindStage(path);
+
+	if(!kind)
+	{
+		fprintf(stderr, "%s: unknown shader stage, use one of .vert .tesc .tese .geom .frag .comp\n", path);
+		return -1;
+	}
+	if(spirvOutputPath(output, path, directory) == -1 || strchr(path, '"') || strchr(output, '"') || strchr(glslang, '"'))
+	{
+		fprintf(stderr, "%s: path too long or quoted\n", path);
+		return -1;
+	}
+	memset(&stage, 0, sizeof(stage));
+	stage.type = kind->type;
+	stage.path = path;
+	/* reports its own errors through the glc log */
+	if(glcPreprocessShader(&stage, defines, defineCount, &source, &length) == -1)
+		return -1;
+	snprintf(command, sizeof(command), "\"%s\" -G --stdin -S %s -o \"%s\"", glslang, kind->name, output);
+	fflush(stdout);
+	if(!(pipe = popen(command, "w")))
+	{
+		fprintf(stderr, "%s: could not run %s\n", path, glslang);
+		free(source);
+		return -1;
+	}
+	fwrite(source, 1, (size_t)length, pipe);
+	status = pclose(pipe);
+	free(source);
+	if(status)
+	{
+		fprintf(stderr, "%s: failed\n", path);
+		return -1;
+	}
+	printf("%s -> %s\n", path, output);
+	return 1;
+}
+
+int main(int argc, char** argv)
+{
+	int i, failures = 0, shaders = 0, defineCount = 0;
+	const char* directory = NULL;
+	const char* glslang = "glslangValidator";
+	const char* defines[SPIRV_MAX_DEFINES];
+
+#if !defined(_WIN32)
+	/* a compiler that fails to start must not take the tool down with it */
+	signal(SIGPIPE, SIG_IGN);
+#endif
+	for(i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], "-o") || !strcmp(argv[i], "--glslang"))
+		{
+			if(i + 1 == argc)
+			{
+				spirvUsage();
+				return 1;
+			}
+			if(argv[i][1] == 'o')
+				directory = argv[++i];
+			else
+				glslang = argv[++i];
+		}
+		else if(!strncmp(argv[i], "-D", 2))
+		{
+			const char* define = argv[i][2] ? argv[i] + 2 : (i + 1 < argc ? argv[++i] : NULL);
+			if(!define || defineCount == SPIRV_MAX_DEFINES)
+			{
+				spirvUsage();
+				return 1;
+			}
+			defines[defineCount++] = define;
+		}
+	}
+	/* defines apply to every shader, wherever they stand */
+	for(i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], "-o") || !strcmp(argv[i], "--glslang") || !strcmp(argv[i], "-D"))
+			i++;
+		else if(strncmp(argv[i], "-D", 2))
+		{
+			shaders++;
+			if(spirvCompile(argv[i], directory, glslang, defines, defineCount) == -1)
+				failures++;
+		}
+	}
+	if(!shaders)
+	{
+		spirvUsage();
+		return 1;
+	}
+	return failures > 125 ? 125 : failures;
+}